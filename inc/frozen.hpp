@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "string_ref.hpp"
+#include "value.hpp"
+
+namespace jsoncpp
+{
+
+class FrozenDocument;
+
+/**
+ * @brief Read-only view of a value inside FrozenDocument.
+ * Views are two pointers wide and valid as long as the document is alive and not assigned to.
+ * Lookups never allocate, missing elements are reported as null values.
+ */
+class FrozenValue
+{
+public:
+	FrozenValue();
+
+	/**
+	 * type Returns value type.
+	 * @return Value type.
+	 */
+	Value::Type type() const
+	{
+		return (Value::Type)node_->type;
+	}
+
+	inline bool is_none() const   { return type() == Value::Type::None;   }
+	inline bool is_bool() const   { return type() == Value::Type::Bool;   }
+	inline bool is_int() const    { return type() == Value::Type::Int;    }
+	inline bool is_float() const  { return type() == Value::Type::Float;  }
+	inline bool is_string() const { return type() == Value::Type::String; }
+	inline bool is_array() const  { return type() == Value::Type::Array;  }
+	inline bool is_object() const { return type() == Value::Type::Object; }
+
+	/**
+	 * size Returns number of elements of array or object, length of string.
+	 * @return Element count, zero for other types.
+	 */
+	size_t size() const
+	{
+		return node_->size;
+	}
+
+	/**
+	 * operator[] Returns element of array, or member value of object in key order.
+	 * @param index Element index.
+	 * @return Element view, null value if index is out of range.
+	 */
+	FrozenValue operator[]( size_t index ) const;
+	FrozenValue operator[]( int index ) const
+	{
+		return index < 0 ? FrozenValue() : (*this)[(size_t)index];
+	}
+
+	/**
+	 * operator[] Looks up object member by binary search over sorted keys.
+	 * @param key Member key.
+	 * @return Member view, null value if there is no such member.
+	 */
+	FrozenValue operator[]( const StringRef &key ) const;
+	FrozenValue operator[]( const char *key ) const
+	{
+		return (*this)[StringRef( key )];
+	}
+
+	/**
+	 * has Checks if object has member.
+	 * @param key Member key.
+	 * @return True if member exists.
+	 */
+	bool has( const StringRef &key ) const;
+
+	/**
+	 * key Returns key of object member, members are sorted by key bytes.
+	 * @param index Member index.
+	 * @return Key characters, empty if index is out of range.
+	 */
+	StringRef key( size_t index ) const;
+
+	/**
+	 * Scalar conversions. Numbers and booleans convert into each other, strings are not parsed.
+	 * @return Converted value, zero or false for other types.
+	 */
+	Value::Int as_int() const;
+	Value::Float as_double() const;
+	Value::Bool as_bool() const;
+
+	/**
+	 * string_ref Returns string contents, zero terminated, without copying.
+	 * @return String reference, empty if value is not a string.
+	 */
+	StringRef string_ref() const;
+	std::string as_string() const
+	{
+		return string_ref().str();
+	}
+
+	/**
+	 * thaw Makes mutable copy of value and its subtree. Document keeps object members sorted by key,
+	 * so thawed objects list members in key order rather than in the order they had before freezing.
+	 * @return Value object.
+	 */
+	Value thaw() const;
+
+private:
+	friend class FrozenDocument;
+
+	/**
+	 * @brief Fixed size value record. Children of a container are stored next to each other,
+	 * object keys first (sorted) followed by member values in the same order.
+	 * Offsets are relative to document start, so the buffer holds no pointers.
+	 */
+	struct Node
+	{
+		uint64_t type : 8;
+		uint64_t size : 56; // String length or element count
+		union
+		{
+			Value::Int int_;
+			Value::Float float_;
+			Value::Bool bool_;
+			uint64_t offset_;  // Byte offset of characters or of first child record
+		};
+	};
+
+	FrozenValue( const char *base, const Node *node ) :
+		base_( base ),
+		node_( node )
+	{}
+
+	const Node* child( size_t index ) const
+	{
+		return reinterpret_cast<const Node*>( base_ + node_->offset_ ) + index;
+	}
+
+	static const Node none_;
+
+	const char *base_;
+	const Node *node_;
+};
+
+/**
+ * @brief Immutable copy of a document packed into one contiguous buffer.
+ * Containers are laid out children first, so iterating an array or object reads memory sequentially,
+ * and object members are found by binary search. Document can be shared between threads without locking.
+ */
+class FrozenDocument
+{
+public:
+	FrozenDocument();
+	explicit FrozenDocument( const Value &value );
+
+	/**
+	 * root Returns top level value.
+	 * @return Value view.
+	 */
+	FrozenValue root() const;
+
+	/**
+	 * size Returns buffer size.
+	 * @return Size in bytes.
+	 */
+	size_t size() const;
+
+private:
+	typedef FrozenValue::Node Node;
+
+	std::vector<Node> buffer_;
+
+	class Builder;
+};
+
+} // namespace jsoncpp
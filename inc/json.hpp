@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <sys/uio.h>
 #include "error.hpp"
 #include "value.hpp"
 
@@ -20,18 +22,50 @@ public:
 	{
 		char indent_char;
 		unsigned indent_size;
+		/**
+		 * Number of threads used to serialize large arrays and objects (0 - hardware concurrency, 1 - serial).
+		 */
+		unsigned threads;
+		/**
+		 * Minimal number of elements of array or object to be serialized in parallel.
+		 */
+		size_t parallel_threshold;
 
 		Format() :
 			indent_char( ' ' ),
-			indent_size( 0 )
+			indent_size( 0 ),
+			threads( 1 ),
+			parallel_threshold( 4096 )
 		{}
 		Format( char indent_char, unsigned indent_size ) :
 			indent_char( indent_char ),
-			indent_size( indent_size )
+			indent_size( indent_size ),
+			threads( 1 ),
+			parallel_threshold( 4096 )
 		{}
 		std::string indent( unsigned level ) const;
 	};
 
+	/**
+	 * @brief JSON split into segments for scatter-gather output (writev).
+	 * Long strings are referenced in place, so the source value must outlive segments and stay unmodified.
+	 * Everything else (punctuation, numbers, escapes and short strings) is stored in the buffer.
+	 */
+	struct Segments
+	{
+		std::vector<struct iovec> iov;
+		std::string buffer;
+		/**
+		 * Minimal length of unescaped string part, which is referenced instead of copied.
+		 */
+		size_t min_reference_size;
+
+		Segments() :
+			min_reference_size( 256 )
+		{}
+		size_t size() const;
+	};
+
 	/**
 	 * @brief validate Validates string as JSON.
 	 * @param json String that contains JSON data.
@@ -48,6 +82,35 @@ public:
 	 */
 	static Value parse( const std::string &json, Error &e );
 
+	/**
+	 * @brief parse Parse JSON string, sharing object keys through the pool.
+	 * Repeated keys, within one document or across parses using the same pool, share one allocation.
+	 * @param json String that contains JSON data.
+	 * @param e Result variable.
+	 * @param pool Key interning pool.
+	 * @return Variadic value object.
+	 */
+	static Value parse( const std::string &json, Error &e, KeyPool &pool );
+
+	/**
+	 * @brief parse Parse JSON string, allocating strings, arrays and objects from the resource.
+	 * @param json String that contains JSON data.
+	 * @param e Result variable.
+	 * @param resource Memory resource, must outlive parsed value.
+	 * @param pool Optional key interning pool.
+	 * @return Variadic value object.
+	 */
+	static Value parse( const std::string &json, Error &e, MemoryResource &resource, KeyPool *pool = nullptr );
+
+	/**
+	 * @brief measure Calculate exact length of JSON string built from value.
+	 * No output is produced, so it may be used to size buffers up front.
+	 * @param value Data object to measure.
+	 * @param formatter Formatting information.
+	 * @return JSON string length in bytes.
+	 */
+	static size_t measure( const Value &value, const Format &formatter = Format() );
+
 	/**
 	 * @brief build Build JSON string from value.
 	 * @param value Data object to build JSON from.
@@ -65,6 +128,16 @@ public:
 	 */
 	static std::string build( const Value &value, Error &e, const Format &formatter );
 
+	/**
+	 * @brief build Build JSON from value as a list of segments.
+	 * Note: writev accepts at most IOV_MAX segments per call.
+	 * @param value Data object to build JSON from.
+	 * @param e Result variable.
+	 * @param formatter Formatting information.
+	 * @param segments Output segments.
+	 */
+	static void build( const Value &value, Error &e, const Format &formatter, Segments &segments );
+
 	/**
 	 * @brief format Format JSON string using specific formatting settings.
 	 * @param json Unformatted JSON data in string form.
@@ -83,4 +156,222 @@ public:
 	static std::string minimize( const std::string &json, Error &e);
 };
 
+/**
+ * @brief Streaming JSON writer. Emits JSON directly, without building a Value tree.
+ * Nesting is checked on every call. The first misuse is stored as error and all further calls are ignored.
+ */
+class JsonWriter
+{
+public:
+	/**
+	 * @brief Output sink prototype.
+	 */
+	typedef std::function<void(const char *data, size_t size)> Sink;
+
+	/**
+	 * @brief Constructors
+	 * @param buffer String, which JSON is appended to.
+	 * @param sink Function, which receives JSON in chunks.
+	 * @param formatter Formatting information.
+	 */
+	JsonWriter( std::string &buffer, const Json::Format &formatter = Json::Format() );
+	JsonWriter( Sink sink, const Json::Format &formatter = Json::Format() );
+	~JsonWriter();
+
+	/**
+	 * @brief Container boundaries.
+	 * @return Writer reference (this).
+	 */
+	JsonWriter& begin_object();
+	JsonWriter& end_object();
+	JsonWriter& begin_array();
+	JsonWriter& end_array();
+
+	/**
+	 * key Writes object key. Must be followed by a value or container.
+	 * @param k Key.
+	 * @return Writer reference (this).
+	 */
+	JsonWriter& key( const std::string &k );
+	JsonWriter& key( const char *k );
+
+	/**
+	 * value Writes a value. Without arguments writes null.
+	 * @return Writer reference (this).
+	 */
+	JsonWriter& value();
+	JsonWriter& value( bool v );
+	JsonWriter& value( int32_t v );
+	JsonWriter& value( uint32_t v );
+	JsonWriter& value( int64_t v );
+	JsonWriter& value( uint64_t v );
+	JsonWriter& value( float v );
+	JsonWriter& value( double v );
+	JsonWriter& value( const std::string &v );
+	JsonWriter& value( const char *v );
+	JsonWriter& value( const Value &v );
+
+	/**
+	 * flush Passes buffered output to sink.
+	 */
+	void flush();
+
+	/**
+	 * complete Checks if a whole top level value has been written.
+	 * @return True if document is complete.
+	 */
+	bool complete() const;
+
+	/**
+	 * error Returns first misuse error.
+	 * @return Error reference.
+	 */
+	const Error& error() const;
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Pull JSON reader. Reads values one by one, without building a Value tree.
+ * The first error is stored and all further calls fail.
+ * Note: JSON string is referenced, so it must outlive the reader.
+ */
+class JsonReader
+{
+public:
+	JsonReader( const std::string &json );
+	~JsonReader();
+
+	/**
+	 * begin_object Enters object.
+	 * @return True if object begins at current position.
+	 */
+	bool begin_object();
+
+	/**
+	 * next_key Reads next object key. Must be followed by reading or skipping the value.
+	 * @param key Key.
+	 * @return False if object is over (or on error).
+	 */
+	bool next_key( std::string &key );
+
+	/**
+	 * begin_array Enters array.
+	 * @return True if array begins at current position.
+	 */
+	bool begin_array();
+
+	/**
+	 * next_element Moves to next array element. Must be followed by reading or skipping the value.
+	 * @return False if array is over (or on error).
+	 */
+	bool next_element();
+
+	/**
+	 * read Reads a value of specific type.
+	 * @param v Result.
+	 * @return True on success.
+	 */
+	bool read( bool &v );
+	bool read( Value::Int &v );
+	bool read( uint64_t &v );
+	bool read( Value::Float &v );
+	bool read( std::string &v );
+	bool read( Value &v );
+
+	/**
+	 * skip Skips a value without building it.
+	 * @return True on success.
+	 */
+	bool skip();
+
+	/**
+	 * finish Checks that the document is over.
+	 * @return True if no data is left and there were no errors.
+	 */
+	bool finish();
+
+	/**
+	 * fail Sets error (if not set yet), so that all further calls fail.
+	 * @param code Error code.
+	 */
+	void fail( Error::ErrorCodes code );
+
+	/**
+	 * error Returns first error.
+	 * @return Error reference.
+	 */
+	const Error& error() const;
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> impl_;
+};
+
+class JsonLiteral;
+
+namespace literals
+{
+
+constexpr JsonLiteral operator"" _json( const char *text, size_t size );
+
+} // namespace literals
+
+/**
+ * @brief Embedded JSON text, e.g. R"({"key": 1})"_json.
+ * Literal is constant initialized, so it costs nothing at static initialization.
+ * Text is parsed on first access only, once per literal. Parsed values are looked up by the address
+ * of literal text, without locking, and are never released. So literals are only made by _json,
+ * from text which lives and stays unchanged until program exit.
+ */
+class JsonLiteral
+{
+public:
+	constexpr const char* data() const
+	{
+		return text_;
+	}
+
+	constexpr size_t size() const
+	{
+		return size_;
+	}
+
+	/**
+	 * value Returns parsed value. Value is immutable and lives until program exit.
+	 * @param e Result variable.
+	 * @return Value reference (None if text is not valid JSON).
+	 */
+	const Value& value( Error &e ) const;
+	const Value& value() const;
+
+	operator const Value&() const
+	{
+		return value();
+	}
+
+private:
+	friend constexpr JsonLiteral literals::operator"" _json( const char *text, size_t size );
+
+	constexpr JsonLiteral( const char *text, size_t size ) :
+		text_( text ),
+		size_( size )
+	{}
+
+	const char *text_;
+	size_t size_;
+};
+
+namespace literals
+{
+
+constexpr JsonLiteral operator"" _json( const char *text, size_t size )
+{
+	return JsonLiteral( text, size );
+}
+
+} // namespace literals
+
 } // namespace jsoncpp
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Immutable reference counted string, used as object key.
+ * Copies share one allocation. Keys interned by the same pool share it across values and parses.
+ */
+class Key
+{
+public:
+	Key() noexcept :
+		rep_( nullptr )
+	{}
+	Key( const char *s ) :
+		Key( s, std::strlen( s ) )
+	{}
+	Key( const char *s, size_t n ) :
+		rep_( new Rep( std::string( s, n ), hash( s, n ) ) )
+	{}
+	Key( const std::string &s ) :
+		rep_( new Rep( s, hash( s.data(), s.size() ) ) )
+	{}
+	Key( std::string &&s ) :
+		rep_( new Rep( std::move( s ) ) )
+	{}
+	Key( const Key &k ) noexcept :
+		rep_( k.rep_ )
+	{
+		retain();
+	}
+	Key( Key &&k ) noexcept :
+		rep_( k.rep_ )
+	{
+		k.rep_ = nullptr;
+	}
+	~Key()
+	{
+		release();
+	}
+
+	Key& operator=( const Key &k ) noexcept
+	{
+		Key tmp( k );
+		std::swap( rep_, tmp.rep_ );
+		return *this;
+	}
+	Key& operator=( Key &&k ) noexcept
+	{
+		std::swap( rep_, k.rep_ );
+		return *this;
+	}
+
+	/**
+	 * str Returns key string.
+	 * @return String reference.
+	 */
+	const std::string& str() const
+	{
+		return rep_ ? rep_->str : blank();
+	}
+
+	operator const std::string&() const
+	{
+		return str();
+	}
+
+	const char* c_str() const { return str().c_str(); }
+	const char* data() const  { return str().data();  }
+	size_t size() const       { return str().size();  }
+	bool empty() const        { return str().empty(); }
+
+	/**
+	 * hash Returns precalculated key hash.
+	 * @return Hash value, same as hash() of key string.
+	 */
+	uint32_t hash() const
+	{
+		return rep_ ? rep_->hash : hash( "", 0 );
+	}
+
+	/**
+	 * shares Checks if keys share the same allocation.
+	 * @return True if keys are known to be equal without comparing strings.
+	 */
+	bool shares( const Key &k ) const
+	{
+		return rep_ == k.rep_;
+	}
+
+	/**
+	 * interned Checks if key was made by KeyPool, so that its allocation is shared by equal keys.
+	 * @return True for pool keys and their copies.
+	 */
+	bool interned() const
+	{
+		return rep_ && rep_->interned;
+	}
+
+	/**
+	 * encoded Returns encoded form of interned key, as stored by encode().
+	 * @return Encoded string, nullptr if there is none yet or key is not interned.
+	 */
+	const std::string* encoded() const
+	{
+		return interned() ? rep_->encoded.load( std::memory_order_acquire ) : nullptr;
+	}
+
+	/**
+	 * encode Stores encoded form of interned key, e.g. quoted JSON string, so that it is encoded
+	 * once per pool key. Keys are shared across values and threads, so the form must only depend
+	 * on key string. If another thread stored it first, that string is kept.
+	 * @param s Encoded key.
+	 * @return Stored string, s itself if key is not interned.
+	 */
+	const std::string& encode( std::string &&s ) const;
+
+	/**
+	 * hash FNV-1a hash of a string.
+	 * @return Hash value.
+	 */
+	static uint32_t hash( const char *s, size_t n )
+	{
+		uint32_t h = 2166136261u;
+		for( size_t i = 0; i < n; i++ )
+		{
+			h = ( h ^ (unsigned char)s[i] ) * 16777619u;
+		}
+		return h;
+	}
+
+	bool equals( const char *s, size_t n ) const
+	{
+		return size() == n && std::memcmp( data(), s, n ) == 0;
+	}
+
+	bool operator==( const Key &k ) const
+	{
+		return shares( k ) || ( hash() == k.hash() && equals( k.data(), k.size() ) );
+	}
+	bool operator!=( const Key &k ) const
+	{
+		return !( *this == k );
+	}
+	bool operator<( const Key &k ) const
+	{
+		return str() < k.str();
+	}
+
+private:
+	friend class KeyPool;
+
+	struct Rep
+	{
+		std::atomic<uint32_t> refs;
+		uint32_t hash;
+		bool interned = false;
+		std::atomic<std::string*> encoded{ nullptr }; // Set once, by encode() of interned keys
+		std::string str;
+
+		Rep( std::string &&s, uint32_t h ) :
+			refs( 1 ),
+			hash( h ),
+			str( std::move( s ) )
+		{}
+		Rep( const std::string &s, uint32_t h ) :
+			refs( 1 ),
+			hash( h ),
+			str( s )
+		{}
+		Rep( std::string &&s ) :
+			refs( 1 ),
+			hash( Key::hash( s.data(), s.size() ) ),
+			str( std::move( s ) )
+		{}
+		~Rep()
+		{
+			delete encoded.load( std::memory_order_relaxed );
+		}
+	};
+
+	Rep *rep_;
+
+	static const std::string& blank();
+
+	void retain() noexcept
+	{
+		if ( rep_ )
+		{
+			rep_->refs.fetch_add( 1, std::memory_order_relaxed );
+		}
+	}
+	void release() noexcept
+	{
+		if ( rep_ && rep_->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+		{
+			delete rep_;
+		}
+		rep_ = nullptr;
+	}
+};
+
+inline bool operator==( const Key &lhs, const std::string &rhs ) { return lhs.equals( rhs.data(), rhs.size() ); }
+inline bool operator==( const std::string &lhs, const Key &rhs ) { return rhs.equals( lhs.data(), lhs.size() ); }
+inline bool operator==( const Key &lhs, const char *rhs )        { return lhs.equals( rhs, std::strlen( rhs ) ); }
+inline bool operator==( const char *lhs, const Key &rhs )        { return rhs.equals( lhs, std::strlen( lhs ) ); }
+inline bool operator!=( const Key &lhs, const std::string &rhs ) { return !( lhs == rhs ); }
+inline bool operator!=( const std::string &lhs, const Key &rhs ) { return !( lhs == rhs ); }
+inline bool operator!=( const Key &lhs, const char *rhs )        { return !( lhs == rhs ); }
+inline bool operator!=( const char *lhs, const Key &rhs )        { return !( lhs == rhs ); }
+
+/**
+ * @brief Key interning table.
+ * Equal strings interned by one pool share a single Key allocation, which stays alive
+ * while either the pool or any value holding it does. Pool may be shared between threads.
+ */
+class KeyPool
+{
+public:
+	/**
+	 * intern Returns shared key for specified string.
+	 * @return Key instance.
+	 */
+	Key intern( const char *s, size_t n );
+	Key intern( const std::string &s );
+
+	/**
+	 * size Returns number of distinct keys in the pool.
+	 * @return Key count.
+	 */
+	size_t size() const;
+
+	/**
+	 * clear Drops pool references. Keys held by values stay valid.
+	 */
+	void clear();
+
+private:
+	mutable std::mutex mutex_;
+	std::unordered_multimap<uint32_t, Key> keys_;
+};
+
+} // namespace jsoncpp
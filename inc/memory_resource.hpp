@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Polymorphic memory source, modelled after std::pmr::memory_resource.
+ */
+class MemoryResource
+{
+public:
+	virtual ~MemoryResource() {}
+
+	void* allocate( size_t bytes, size_t alignment = alignof( std::max_align_t ) )
+	{
+		return do_allocate( bytes, alignment );
+	}
+
+	void deallocate( void *p, size_t bytes, size_t alignment = alignof( std::max_align_t ) )
+	{
+		do_deallocate( p, bytes, alignment );
+	}
+
+	bool is_equal( const MemoryResource &other ) const noexcept
+	{
+		return this == &other || do_is_equal( other );
+	}
+
+protected:
+	virtual void* do_allocate( size_t bytes, size_t alignment ) = 0;
+	virtual void do_deallocate( void *p, size_t bytes, size_t alignment ) = 0;
+	virtual bool do_is_equal( const MemoryResource &other ) const noexcept
+	{
+		return this == &other;
+	}
+};
+
+/**
+ * default_resource Returns resource used when none is specified (operator new/delete by default).
+ * @return Resource pointer.
+ */
+MemoryResource* default_resource() noexcept;
+
+/**
+ * set_default_resource Replaces default resource. Values keep using resources they were allocated from.
+ * @param resource New default resource, or nullptr to restore operator new/delete.
+ * @return Previous default resource.
+ */
+MemoryResource* set_default_resource( MemoryResource *resource ) noexcept;
+
+/**
+ * @brief Arena resource. Memory is carved from growing blocks and is only returned by release() or destruction.
+ * Not thread-safe.
+ */
+class MonotonicResource : public MemoryResource
+{
+public:
+	explicit MonotonicResource( size_t block_size = 4096, MemoryResource *upstream = default_resource() );
+	~MonotonicResource();
+
+	/**
+	 * release Frees all allocated memory. Values allocated from the resource must not be used afterwards.
+	 */
+	void release();
+
+protected:
+	void* do_allocate( size_t bytes, size_t alignment ) override;
+	void do_deallocate( void *p, size_t bytes, size_t alignment ) override;
+
+private:
+	struct Block
+	{
+		void *data;
+		size_t size;
+	};
+
+	MemoryResource *upstream_;
+	size_t block_size_;
+	std::vector<Block> blocks_;
+	char *current_;
+	size_t left_;
+
+	MonotonicResource( const MonotonicResource& ) = delete;
+	MonotonicResource& operator=( const MonotonicResource& ) = delete;
+};
+
+/**
+ * @brief Standard allocator adaptor over MemoryResource. Containers copied from one another share the resource.
+ */
+template <typename T>
+class Allocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	Allocator() noexcept :
+		resource_( default_resource() )
+	{}
+	Allocator( MemoryResource *resource ) noexcept :
+		resource_( resource )
+	{}
+	template <typename U>
+	Allocator( const Allocator<U> &a ) noexcept :
+		resource_( a.resource() )
+	{}
+
+	T* allocate( size_t n )
+	{
+		return static_cast<T*>( resource_->allocate( n * sizeof( T ), alignof( T ) ) );
+	}
+
+	void deallocate( T *p, size_t n )
+	{
+		resource_->deallocate( p, n * sizeof( T ), alignof( T ) );
+	}
+
+	MemoryResource* resource() const noexcept
+	{
+		return resource_;
+	}
+
+private:
+	MemoryResource *resource_;
+};
+
+template <typename T, typename U>
+inline bool operator==( const Allocator<T> &lhs, const Allocator<U> &rhs ) noexcept
+{
+	return lhs.resource()->is_equal( *rhs.resource() );
+}
+
+template <typename T, typename U>
+inline bool operator!=( const Allocator<T> &lhs, const Allocator<U> &rhs ) noexcept
+{
+	return !( lhs == rhs );
+}
+
+} // namespace jsoncpp
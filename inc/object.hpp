@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "key.hpp"
+#include "string_ref.hpp"
+
+/**
+ * Objects with more members than this are indexed by a hash table, smaller ones are searched linearly.
+ */
+#ifndef JSONCPP_OBJECT_INDEX_THRESHOLD
+#define JSONCPP_OBJECT_INDEX_THRESHOLD 8
+#endif
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Insertion-ordered string keyed map.
+ * Members are stored contiguously in insertion order. Small maps are searched linearly,
+ * larger ones maintain an open-addressing index over member positions.
+ * Like with std::vector, inserting members may invalidate references to other members.
+ * Keys are immutable shared strings (see Key) and must not be reassigned through iterators.
+ */
+template <typename T, typename Alloc = std::allocator<std::pair<Key, T> > >
+class ObjectMap
+{
+public:
+	typedef Key key_type;
+	typedef T mapped_type;
+	typedef std::pair<Key, T> value_type;
+	typedef Alloc allocator_type;
+	typedef std::vector<value_type, Alloc> container_type;
+	typedef typename container_type::iterator iterator;
+	typedef typename container_type::const_iterator const_iterator;
+	typedef size_t size_type;
+
+	ObjectMap()
+	{}
+	explicit ObjectMap( const Alloc &alloc ) :
+		items_( alloc ),
+		index_( alloc )
+	{}
+	ObjectMap( const ObjectMap &rhs ) = default;
+	ObjectMap( ObjectMap &&rhs ) = default;
+	ObjectMap( std::initializer_list<value_type> items, const Alloc &alloc = Alloc() ) :
+		items_( alloc ),
+		index_( alloc )
+	{
+		reserve( items.size() );
+		for( const auto &i : items )
+		{
+			emplace( i.first, i.second );
+		}
+	}
+
+	iterator begin()              { return items_.begin(); }
+	iterator end()                { return items_.end();   }
+	const_iterator begin() const  { return items_.begin(); }
+	const_iterator end() const    { return items_.end();   }
+	const_iterator cbegin() const { return items_.begin(); }
+	const_iterator cend() const   { return items_.end();   }
+
+	size_type size() const
+	{
+		return items_.size();
+	}
+
+	bool empty() const
+	{
+		return items_.empty();
+	}
+
+	void clear()
+	{
+		items_.clear();
+		index_.clear();
+	}
+
+	ObjectMap& operator=( const ObjectMap &rhs ) = default;
+	ObjectMap& operator=( ObjectMap &&rhs ) = default;
+
+	void reserve( size_type n )
+	{
+		items_.reserve( n );
+	}
+
+	allocator_type get_allocator() const
+	{
+		return items_.get_allocator();
+	}
+
+	iterator find( const Key &key )               { return items_.begin() + locate( key ); }
+	iterator find( const std::string &key )       { return items_.begin() + locate( key ); }
+	iterator find( const char *key )              { return items_.begin() + locate( key ); }
+	iterator find( const StringRef &key )         { return items_.begin() + locate( key ); }
+	const_iterator find( const Key &key ) const         { return items_.begin() + locate( key ); }
+	const_iterator find( const std::string &key ) const { return items_.begin() + locate( key ); }
+	const_iterator find( const char *key ) const        { return items_.begin() + locate( key ); }
+	const_iterator find( const StringRef &key ) const   { return items_.begin() + locate( key ); }
+
+	size_type count( const Key &key ) const         { return locate( key ) < items_.size() ? 1 : 0; }
+	size_type count( const std::string &key ) const { return locate( key ) < items_.size() ? 1 : 0; }
+	size_type count( const char *key ) const        { return locate( key ) < items_.size() ? 1 : 0; }
+	size_type count( const StringRef &key ) const   { return locate( key ) < items_.size() ? 1 : 0; }
+
+	template <typename K>
+	T& at( const K &key )
+	{
+		auto position = locate( key );
+		if ( position == items_.size() )
+		{
+			throw std::out_of_range( "ObjectMap::at" );
+		}
+		return items_[position].second;
+	}
+
+	template <typename K>
+	const T& at( const K &key ) const
+	{
+		auto position = locate( key );
+		if ( position == items_.size() )
+		{
+			throw std::out_of_range( "ObjectMap::at" );
+		}
+		return items_[position].second;
+	}
+
+	template <typename K>
+	T& operator[]( K &&key )
+	{
+		return emplace( std::forward<K>( key ) ).first->second;
+	}
+
+	/**
+	 * emplace Appends a member, unless the key already exists.
+	 * @return Member iterator and true if inserted.
+	 */
+	template <typename K, typename ...Args>
+	std::pair<iterator, bool> emplace( K &&key, Args&&... args )
+	{
+		auto position = locate( key );
+		if ( position < items_.size() )
+		{
+			return std::make_pair( items_.begin() + position, false );
+		}
+		items_.emplace_back( std::piecewise_construct,
+							 std::forward_as_tuple( std::forward<K>( key ) ),
+							 std::forward_as_tuple( std::forward<Args>( args )... ) );
+		index( items_.size() - 1 );
+		return std::make_pair( items_.end() - 1, true );
+	}
+
+	std::pair<iterator, bool> insert( const value_type &v )
+	{
+		return emplace( v.first, v.second );
+	}
+
+	std::pair<iterator, bool> insert( value_type &&v )
+	{
+		return emplace( std::move( v.first ), std::move( v.second ) );
+	}
+
+	template <typename K>
+	size_type erase( const K &key )
+	{
+		auto i = find( key );
+		if ( i == end() )
+		{
+			return 0;
+		}
+		erase( i );
+		return 1;
+	}
+
+	iterator erase( iterator pos )
+	{
+		return erase( const_iterator( pos ) );
+	}
+
+	iterator erase( const_iterator pos )
+	{
+		auto position = pos - items_.begin();
+		unindex( position );
+		items_.erase( items_.begin() + position );
+		return items_.begin() + position;
+	}
+
+	/**
+	 * Maps are equal if they have the same members, regardless of order.
+	 */
+	bool operator==( const ObjectMap &rhs ) const
+	{
+		if ( size() != rhs.size() )
+		{
+			return false;
+		}
+		for( const auto &i : items_ )
+		{
+			auto j = rhs.find( i.first );
+			if ( j == rhs.end() || !( j->second == i.second ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool operator!=( const ObjectMap &rhs ) const
+	{
+		return !( *this == rhs );
+	}
+
+private:
+	struct Slot
+	{
+		uint32_t hash;
+		uint32_t position; // Member position + 1, zero for empty slot
+	};
+
+	container_type items_;
+	std::vector<Slot, typename std::allocator_traits<Alloc>::template rebind_alloc<Slot> > index_;
+
+	// Returns member position or size() if not found
+	size_t locate( const Key &key ) const
+	{
+		return lookup( key.data(), key.size(), key.hash(), &key );
+	}
+
+	size_t locate( const std::string &key ) const
+	{
+		return lookup( key.data(), key.size(), Key::hash( key.data(), key.size() ), nullptr );
+	}
+
+	size_t locate( const char *key ) const
+	{
+		auto n = std::strlen( key );
+		return lookup( key, n, Key::hash( key, n ), nullptr );
+	}
+
+	size_t locate( const StringRef &key ) const
+	{
+		return lookup( key.data(), key.size(), Key::hash( key.data(), key.size() ), nullptr );
+	}
+
+	static bool equal( const Key &key, const char *s, size_t n, uint32_t h, const Key *k )
+	{
+		return ( k && key.shares( *k ) ) || ( key.hash() == h && key.equals( s, n ) );
+	}
+
+	size_t lookup( const char *key, size_t n, uint32_t h, const Key *k ) const
+	{
+		if ( index_.empty() )
+		{
+			for( size_t i = 0; i < items_.size(); i++ )
+			{
+				if ( equal( items_[i].first, key, n, h, k ) )
+				{
+					return i;
+				}
+			}
+			return items_.size();
+		}
+		auto mask = index_.size() - 1;
+		for( auto i = h & mask; index_[i].position; i = ( i + 1 ) & mask )
+		{
+			const auto &slot = index_[i];
+			if ( slot.hash == h && equal( items_[slot.position - 1].first, key, n, h, k ) )
+			{
+				return slot.position - 1;
+			}
+		}
+		return items_.size();
+	}
+
+	void index( size_t position )
+	{
+		if ( items_.size() <= JSONCPP_OBJECT_INDEX_THRESHOLD )
+		{
+			return;
+		}
+		if ( index_.size() < items_.size() * 2 )
+		{
+			reindex();
+			return;
+		}
+		place( items_[position].first.hash(), position );
+	}
+
+	void place( uint32_t h, size_t position )
+	{
+		auto mask = index_.size() - 1;
+		auto i = h & mask;
+		while( index_[i].position )
+		{
+			i = ( i + 1 ) & mask;
+		}
+		index_[i].hash = h;
+		index_[i].position = (uint32_t)( position + 1 );
+	}
+
+	// Removes member from index before it is erased, members behind it move one position down
+	void unindex( size_t position )
+	{
+		if ( index_.empty() )
+		{
+			return;
+		}
+		if ( items_.size() - 1 <= JSONCPP_OBJECT_INDEX_THRESHOLD )
+		{
+			index_.clear();
+			return;
+		}
+		auto mask = index_.size() - 1;
+		auto i = items_[position].first.hash() & mask;
+		while( index_[i].position != position + 1 )
+		{
+			i = ( i + 1 ) & mask;
+		}
+		// Backward shift deletion: slots of the same probe chain move into the hole,
+		// unless their home slot lies between the hole and them
+		for( auto j = ( i + 1 ) & mask; index_[j].position; j = ( j + 1 ) & mask )
+		{
+			auto home = index_[j].hash & mask;
+			if ( ( ( j - home ) & mask ) >= ( ( j - i ) & mask ) )
+			{
+				index_[i] = index_[j];
+				i = j;
+			}
+		}
+		index_[i] = Slot{ 0, 0 };
+		for( auto &slot : index_ )
+		{
+			if ( slot.position > position + 1 )
+			{
+				slot.position--;
+			}
+		}
+	}
+
+	void reindex()
+	{
+		index_.clear();
+		if ( items_.size() <= JSONCPP_OBJECT_INDEX_THRESHOLD )
+		{
+			return;
+		}
+		size_t capacity = 16;
+		while( capacity < items_.size() * 4 )
+		{
+			capacity <<= 1;
+		}
+		index_.assign( capacity, Slot{ 0, 0 } );
+		for( size_t i = 0; i < items_.size(); i++ )
+		{
+			place( items_[i].first.hash(), i );
+		}
+	}
+};
+
+} // namespace jsoncpp
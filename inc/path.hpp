@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "value.hpp"
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Compiled JSONPath query (RFC 9535 subset), e.g. "$.store..book[?@.price < 10].title".
+ * Supported are member names (.name, ['name']), wildcards (*), recursive descent (..),
+ * indices and unions ([0,-1]), slices ([start:end:step]) and filters ([?expr]). Indices and slice
+ * bounds are integers without leading zeros, within I-JSON range of +-(2^53 - 1).
+ * Filters support relative (@) and absolute ($) queries, string, number, boolean and null literals,
+ * comparisons (== != < <= > >=), logical operators (&& || !), parentheses and existence tests.
+ * Compared queries must be singular, i.e. only have one name or index selector per step, as RFC 9535
+ * requires. Functions (length() etc.) are not supported.
+ * Expression is parsed once, selecting values allocates nothing but the result list.
+ */
+class JsonPath
+{
+public:
+	JsonPath();
+	JsonPath( const std::string &path, Error &e );
+	~JsonPath();
+
+	/**
+	 * init Compiles path expression.
+	 * @param path Path expression.
+	 * @param e Result variable.
+	 * @return True on success, on failure path selects nothing.
+	 */
+	bool init( const std::string &path, Error &e );
+
+	/**
+	 * select Appends selected values to result, in RFC 9535 order.
+	 * @param root Document.
+	 * @param result Value references.
+	 */
+	void select( const Value &root, std::vector<const Value*> &result ) const;
+	void select( Value &root, std::vector<Value*> &result ) const;
+
+	/**
+	 * first Returns first selected value. Evaluation stops at first match.
+	 * @param root Document.
+	 * @return Value pointer, or nullptr if nothing is selected.
+	 */
+	const Value* first( const Value &root ) const;
+	Value* first( Value &root ) const;
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> impl_;
+
+	JsonPath( const JsonPath& ) = delete;
+	JsonPath& operator=( const JsonPath& ) = delete;
+};
+
+} // namespace jsoncpp
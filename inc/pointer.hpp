@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "error.hpp"
+#include "key.hpp"
+#include "value.hpp"
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Compiled JSON Pointer (RFC 6901), e.g. "/a/b~1c/0".
+ * Pointer text is split and unescaped once. Looking up values doesn't allocate.
+ */
+class JsonPointer
+{
+public:
+	JsonPointer();
+	JsonPointer( const std::string &pointer, Error &e );
+
+	/**
+	 * init Compiles pointer text. Empty text points to the whole document.
+	 * @param pointer Pointer text.
+	 * @param e Result variable.
+	 * @return True on success, on failure pointer is left empty.
+	 */
+	bool init( const std::string &pointer, Error &e );
+
+	/**
+	 * str Returns pointer text.
+	 * @return String reference.
+	 */
+	const std::string& str() const;
+
+	/**
+	 * size Returns number of reference tokens.
+	 * @return Token count.
+	 */
+	size_t size() const;
+
+	/**
+	 * find Looks up referenced value.
+	 * @param root Document.
+	 * @return Value pointer, or nullptr if no such value.
+	 */
+	const Value* find( const Value &root ) const;
+	Value* find( Value &root ) const;
+
+	/**
+	 * create Looks up referenced value, adding missing object members on the way.
+	 * Null values become objects, "-" appends to arrays (or makes an array from null).
+	 * @param root Document.
+	 * @return Value pointer, or nullptr if path runs into a scalar or past array end.
+	 * Document is left unchanged in that case.
+	 */
+	Value* create( Value &root ) const;
+
+private:
+	struct Token
+	{
+		Key key;
+		size_t index; // Array index, npos_ if token is not an index, append_ for "-"
+	};
+
+	static const size_t npos_ = (size_t)-1;
+	static const size_t append_ = (size_t)-2;
+
+	std::string text_;
+	std::vector<Token> tokens_;
+
+	template <typename V>
+	V* lookup( V &root ) const;
+	bool creatable( const Value &root ) const;
+};
+
+} // namespace jsoncpp
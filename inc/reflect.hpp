@@ -0,0 +1,463 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "json.hpp"
+
+/**
+ * Field list helpers (up to 32 fields).
+ */
+#define JSONCPP_EXPAND( x ) x
+#define JSONCPP_CONCAT_( a, b ) a##b
+#define JSONCPP_CONCAT( a, b ) JSONCPP_CONCAT_( a, b )
+#define JSONCPP_NARG_( _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ... ) N
+#define JSONCPP_NARG( ... ) JSONCPP_EXPAND( JSONCPP_NARG_( __VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 ) )
+#define JSONCPP_FOR_EACH_1( M, x ) M( x )
+#define JSONCPP_FOR_EACH_2( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_1( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_3( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_2( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_4( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_3( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_5( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_4( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_6( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_5( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_7( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_6( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_8( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_7( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_9( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_8( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_10( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_9( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_11( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_10( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_12( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_11( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_13( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_12( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_14( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_13( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_15( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_14( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_16( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_15( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_17( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_16( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_18( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_17( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_19( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_18( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_20( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_19( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_21( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_20( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_22( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_21( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_23( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_22( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_24( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_23( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_25( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_24( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_26( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_25( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_27( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_26( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_28( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_27( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_29( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_28( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_30( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_29( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_31( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_30( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH_32( M, x, ... ) M( x ) JSONCPP_EXPAND( JSONCPP_FOR_EACH_31( M, __VA_ARGS__ ) )
+#define JSONCPP_FOR_EACH( M, ... ) JSONCPP_EXPAND( JSONCPP_CONCAT( JSONCPP_FOR_EACH_, JSONCPP_NARG( __VA_ARGS__ ) )( M, __VA_ARGS__ ) )
+
+#define JSONCPP_REFLECT_FIELD( field ) visitor( #field, object.field );
+#define JSONCPP_REFLECT_CASE( field ) \
+	case ::jsoncpp::reflect_hash( #field ): \
+		if ( key == #field ) \
+		{ \
+			visitor( object.field ); \
+			return true; \
+		} \
+		break;
+
+/**
+ * @brief Describes structure fields for direct serialization and deserialization.
+ * Must be used at namespace scope of the structure (functions are found by argument dependent lookup).
+ * Field names are dispatched by hash, which is calculated at compile time.
+ * Colliding names would produce duplicate case values, so the hash is guaranteed to be perfect.
+ * Example: JSONCPP_REFLECT( Point, x, y )
+ */
+#define JSONCPP_REFLECT( Type, ... ) \
+	template <class Visitor> \
+	inline void jsoncpp_fields( const Type &object, Visitor &visitor ) \
+	{ \
+		JSONCPP_FOR_EACH( JSONCPP_REFLECT_FIELD, __VA_ARGS__ ) \
+	} \
+	template <class Visitor> \
+	inline bool jsoncpp_field( Type &object, const std::string &key, uint32_t hash, Visitor &visitor ) \
+	{ \
+		switch( hash ) \
+		{ \
+		JSONCPP_FOR_EACH( JSONCPP_REFLECT_CASE, __VA_ARGS__ ) \
+		default: \
+			break; \
+		} \
+		return false; \
+	}
+
+namespace jsoncpp
+{
+
+/**
+ * reflect_hash Calculates field name hash (FNV-1a) at compile time.
+ */
+constexpr uint32_t reflect_hash( const char *s, uint32_t h = 2166136261u )
+{
+	return *s ? reflect_hash( s + 1, ( h ^ (uint8_t)*s ) * 16777619u ) : h;
+}
+
+/**
+ * reflect_hash Calculates field name hash (FNV-1a) at run time.
+ */
+inline uint32_t reflect_hash( const std::string &s )
+{
+	uint32_t h = 2166136261u;
+	for( auto c : s )
+	{
+		h = ( h ^ (uint8_t)c ) * 16777619u;
+	}
+	return h;
+}
+
+/**
+ * @brief Serialization traits. May be specialized for custom types.
+ */
+template <typename T, typename Enable = void>
+struct ReflectTraits;
+
+/**
+ * IsReflected Checks if type fields are described with JSONCPP_REFLECT.
+ */
+template <typename T>
+struct IsReflected
+{
+	struct Probe
+	{
+		template <typename U>
+		void operator()( const char*, const U& ) {}
+	};
+
+	template <typename U>
+	static auto test( int ) -> decltype( jsoncpp_fields( std::declval<const U&>(), std::declval<Probe&>() ), std::true_type() );
+
+	template <typename U>
+	static std::false_type test( ... );
+
+	static constexpr bool value = decltype( test<T>( 0 ) )::value;
+};
+
+/**
+ * @brief Direct serialization and deserialization of C++ objects, without building Value.
+ * Unknown object keys are skipped on reading. Missing keys leave fields untouched.
+ * Supported are arithmetic types, strings, Value, std::vector, std::array, std::map with string keys,
+ * structures described with JSONCPP_REFLECT and types with ReflectTraits specialization.
+ */
+class Reflect
+{
+public:
+	/**
+	 * @brief write Writes object as JSON value.
+	 * @param writer JSON writer.
+	 * @param object Object to write.
+	 */
+	template <typename T>
+	static void write( JsonWriter &writer, const T &object )
+	{
+		ReflectTraits<T>::write( writer, object );
+	}
+
+	/**
+	 * @brief build Build JSON string from object.
+	 * @param object Object to build JSON from.
+	 * @param e Result variable.
+	 * @param formatter Formatting information.
+	 * @return JSON string.
+	 */
+	template <typename T>
+	static std::string build( const T &object, Error &e, const Json::Format &formatter = Json::Format() )
+	{
+		std::string s;
+		JsonWriter writer( s, formatter );
+		write( writer, object );
+		if ( !writer.error().empty() )
+		{
+			e = writer.error();
+		}
+		return s;
+	}
+
+	/**
+	 * @brief read Reads object from JSON reader.
+	 * @param reader JSON reader.
+	 * @param object Object to read.
+	 * @return True on success.
+	 */
+	template <typename T>
+	static bool read( JsonReader &reader, T &object )
+	{
+		return ReflectTraits<T>::read( reader, object );
+	}
+
+	/**
+	 * @brief parse Parse JSON string into object.
+	 * @param json String that contains JSON data.
+	 * @param object Object to parse into.
+	 * @param e Result variable.
+	 * @return True on success.
+	 */
+	template <typename T>
+	static bool parse( const std::string &json, T &object, Error &e )
+	{
+		JsonReader reader( json );
+		read( reader, object );
+		if ( !reader.finish() )
+		{
+			e = reader.error();
+			return false;
+		}
+		return true;
+	}
+};
+
+template <>
+struct ReflectTraits<bool>
+{
+	static void write( JsonWriter &writer, bool value )
+	{
+		writer.value( value );
+	}
+
+	static bool read( JsonReader &reader, bool &value )
+	{
+		return reader.read( value );
+	}
+};
+
+template <typename T>
+struct ReflectTraits<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+{
+	static void write( JsonWriter &writer, T value )
+	{
+		if ( std::is_signed<T>::value )
+		{
+			writer.value( (int64_t)value );
+		}
+		else
+		{
+			writer.value( (uint64_t)value );
+		}
+	}
+
+	static bool read( JsonReader &reader, T &value )
+	{
+		// Unsigned targets are read as unsigned, so the whole range written above reads back
+		typename std::conditional<std::is_signed<T>::value, Value::Int, uint64_t>::type i;
+		if ( !reader.read( i ) )
+		{
+			return false;
+		}
+		if ( i < (decltype( i ))std::numeric_limits<T>::min() || i > (decltype( i ))std::numeric_limits<T>::max() )
+		{
+			reader.fail( Error::OutOfRange );
+			return false;
+		}
+		value = (T)i;
+		return true;
+	}
+};
+
+template <typename T>
+struct ReflectTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+	static void write( JsonWriter &writer, T value )
+	{
+		writer.value( (double)value );
+	}
+
+	static bool read( JsonReader &reader, T &value )
+	{
+		Value::Float f;
+		if ( !reader.read( f ) )
+		{
+			return false;
+		}
+		value = (T)f;
+		return true;
+	}
+};
+
+template <>
+struct ReflectTraits<std::string>
+{
+	static void write( JsonWriter &writer, const std::string &value )
+	{
+		writer.value( value );
+	}
+
+	static bool read( JsonReader &reader, std::string &value )
+	{
+		return reader.read( value );
+	}
+};
+
+template <>
+struct ReflectTraits<Value>
+{
+	static void write( JsonWriter &writer, const Value &value )
+	{
+		writer.value( value );
+	}
+
+	static bool read( JsonReader &reader, Value &value )
+	{
+		return reader.read( value );
+	}
+};
+
+template <typename T, typename A>
+struct ReflectTraits<std::vector<T, A> >
+{
+	static void write( JsonWriter &writer, const std::vector<T, A> &value )
+	{
+		writer.begin_array();
+		for( const auto &i : value )
+		{
+			ReflectTraits<T>::write( writer, i );
+		}
+		writer.end_array();
+	}
+
+	static bool read( JsonReader &reader, std::vector<T, A> &value )
+	{
+		value.clear();
+		if ( !reader.begin_array() )
+		{
+			return false;
+		}
+		while( reader.next_element() )
+		{
+			value.emplace_back();
+			if ( !ReflectTraits<T>::read( reader, value.back() ) )
+			{
+				return false;
+			}
+		}
+		return reader.error().empty();
+	}
+};
+
+template <typename T, size_t N>
+struct ReflectTraits<std::array<T, N> >
+{
+	static void write( JsonWriter &writer, const std::array<T, N> &value )
+	{
+		writer.begin_array();
+		for( const auto &i : value )
+		{
+			ReflectTraits<T>::write( writer, i );
+		}
+		writer.end_array();
+	}
+
+	static bool read( JsonReader &reader, std::array<T, N> &value )
+	{
+		if ( !reader.begin_array() )
+		{
+			return false;
+		}
+		size_t i = 0;
+		while( reader.next_element() )
+		{
+			if ( i == N )
+			{
+				reader.fail( Error::OutOfRange );
+				return false;
+			}
+			if ( !ReflectTraits<T>::read( reader, value[i++] ) )
+			{
+				return false;
+			}
+		}
+		return reader.error().empty();
+	}
+};
+
+template <typename T, typename C, typename A>
+struct ReflectTraits<std::map<std::string, T, C, A> >
+{
+	static void write( JsonWriter &writer, const std::map<std::string, T, C, A> &value )
+	{
+		writer.begin_object();
+		for( const auto &i : value )
+		{
+			writer.key( i.first );
+			ReflectTraits<T>::write( writer, i.second );
+		}
+		writer.end_object();
+	}
+
+	static bool read( JsonReader &reader, std::map<std::string, T, C, A> &value )
+	{
+		value.clear();
+		if ( !reader.begin_object() )
+		{
+			return false;
+		}
+		std::string key;
+		while( reader.next_key( key ) )
+		{
+			if ( !ReflectTraits<T>::read( reader, value[key] ) )
+			{
+				return false;
+			}
+		}
+		return reader.error().empty();
+	}
+};
+
+template <typename T>
+struct ReflectTraits<T, typename std::enable_if<IsReflected<T>::value>::type>
+{
+	struct FieldWriter
+	{
+		JsonWriter &writer;
+
+		template <typename U>
+		void operator()( const char *name, const U &value )
+		{
+			writer.key( name );
+			ReflectTraits<U>::write( writer, value );
+		}
+	};
+
+	struct FieldReader
+	{
+		JsonReader &reader;
+
+		template <typename U>
+		void operator()( U &value )
+		{
+			ReflectTraits<U>::read( reader, value );
+		}
+	};
+
+	static void write( JsonWriter &writer, const T &value )
+	{
+		FieldWriter visitor{ writer };
+		writer.begin_object();
+		jsoncpp_fields( value, visitor );
+		writer.end_object();
+	}
+
+	static bool read( JsonReader &reader, T &value )
+	{
+		if ( !reader.begin_object() )
+		{
+			return false;
+		}
+		FieldReader visitor{ reader };
+		std::string key;
+		while( reader.next_key( key ) )
+		{
+			if ( !jsoncpp_field( value, key, reflect_hash( key ), visitor ) )
+			{
+				reader.skip();
+			}
+		}
+		return reader.error().empty();
+	}
+};
+
+} // namespace jsoncpp
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace jsoncpp
+{
+
+/**
+ * @brief Non-owning reference to a character sequence.
+ * Referenced data must outlive the reference.
+ */
+class StringRef
+{
+public:
+	StringRef() :
+		data_( "" ),
+		size_( 0 )
+	{}
+	StringRef( const char *s, size_t n ) :
+		data_( s ),
+		size_( n )
+	{}
+	StringRef( const char *s ) :
+		data_( s ),
+		size_( std::strlen( s ) )
+	{}
+	StringRef( const std::string &s ) :
+		data_( s.data() ),
+		size_( s.size() )
+	{}
+
+	const char* data() const  { return data_; }
+	size_t size() const       { return size_; }
+	bool empty() const        { return size_ == 0; }
+	const char* begin() const { return data_; }
+	const char* end() const   { return data_ + size_; }
+
+	char operator[]( size_t i ) const
+	{
+		return data_[i];
+	}
+
+	/**
+	 * str Returns a copy of referenced characters.
+	 * @return String object.
+	 */
+	std::string str() const
+	{
+		return std::string( data_, size_ );
+	}
+
+private:
+	const char *data_;
+	size_t size_;
+};
+
+inline bool operator==( const StringRef &lhs, const StringRef &rhs )
+{
+	return lhs.size() == rhs.size() && std::memcmp( lhs.data(), rhs.data(), lhs.size() ) == 0;
+}
+
+inline bool operator!=( const StringRef &lhs, const StringRef &rhs )
+{
+	return !( lhs == rhs );
+}
+
+} // namespace jsoncpp
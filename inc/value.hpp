@@ -2,11 +2,25 @@
 
 #include <cmath>
 #include <cstdint>
+#include <atomic>
+#include <cstring>
 #include <functional>
 #include <vector>
 #include <string>
 #include <map>
-#include "variant.hpp"
+#include <type_traits>
+#include <utility>
+#include "memory_resource.hpp"
+#include "object.hpp"
+#include "string_ref.hpp"
+
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define JSONCPP_DEPRECATED( msg ) __attribute__(( deprecated( msg ) ))
+#elif defined( _MSC_VER )
+#define JSONCPP_DEPRECATED( msg ) __declspec( deprecated( msg ) )
+#else
+#define JSONCPP_DEPRECATED( msg )
+#endif
 
 
 namespace jsoncpp
@@ -14,6 +28,13 @@ namespace jsoncpp
 
 /**
  * @brief Polymorphic value container, which is able to handle JSON types.
+ * Scalars and short strings are stored inline, longer strings, arrays and objects are kept behind a single pointer.
+ * Such payloads are shared between copies and copied on first mutation. Methods which modify a value
+ * in place (insert(), erase() etc.) keep its payload shareable. Once a mutable reference into a payload
+ * is handed out (get_array(), non-const operator[] etc.), it may be written through at any time, so
+ * that payload is not shared by copies for the rest of its life, and each copy copies its elements.
+ * A copy gets shareable payloads of its own, so copying a finished tree once makes later copies O(1).
+ * Const lookups, comparisons and scalar conversions never allocate.
  */
 class Value
 {
@@ -21,7 +42,7 @@ public:
 	/**
 	 * @brief Value type constants.
 	 */
-	enum class Type
+	enum class Type : uint8_t
 	{
 		None = 0,
 		Int,
@@ -39,8 +60,12 @@ public:
 	typedef double Float;
 	typedef bool Bool;
 	typedef std::string String;
-	typedef std::vector<Value> Array;
-	typedef std::map<std::string, Value> Object;
+	typedef std::vector<Value, Allocator<Value> > Array;
+#ifdef JSONCPP_SORTED_OBJECT
+	typedef std::map<std::string, Value, std::less<std::string>, Allocator<std::pair<const std::string, Value> > > Object;
+#else
+	typedef ObjectMap<Value, Allocator<std::pair<Key, Value> > > Object;
+#endif
 
 	typedef std::function<bool(const Value &element)> ElementPredicate;
 
@@ -64,12 +89,18 @@ public:
 	 */
 	Value();
 	Value( const Type t );
+	Value( const Type t, MemoryResource *resource );
 	Value( const char *s );
 	Value( const Value &rhs );
-	Value( Value&& rhs ) :
-			type_( rhs.type_ ),
-			data_( std::move( rhs.data_ ) )
-	{}
+	Value( const Value &rhs, MemoryResource *resource );
+	Value( String &&value, MemoryResource *resource );
+	Value( Value&& rhs ) noexcept :
+			type_( rhs.type_ )
+	{
+		std::memcpy( cell_, rhs.cell_, sizeof( cell_ ) );
+		rhs.type_ = Type::None;
+	}
+	~Value();
 
 	template<typename T,
 			 typename std::enable_if <std::is_same<T, None>::value     ||
@@ -79,38 +110,49 @@ public:
 									  std::is_same<T, String>::value   ||
 									  std::is_same<T, Array>::value    ||
 									  std::is_same<T, Object>::value>::type* = nullptr>
-	Value( const T &value )
+	Value( const T &value ) :
+		type_( Type::None )
 	{
-		data_ = value;
-		type_ = type();
+		set( value );
+	}
+
+	template<typename T,
+			 typename std::enable_if <std::is_same<T, String>::value   ||
+									  std::is_same<T, Array>::value    ||
+									  std::is_same<T, Object>::value>::type* = nullptr>
+	Value( T &&value ) :
+		type_( Type::None )
+	{
+		set( std::move( value ) );
 	}
 
 	template<typename T,
 			 typename std::enable_if <std::is_same<T, int32_t>::value  ||
 									  std::is_same<T, uint32_t>::value ||
 									  std::is_same<T, uint64_t>::value>::type* = nullptr>
-	Value( const T &value )
+	Value( const T &value ) :
+		type_( Type::None )
 	{
-		data_ = (Int)value;
-		type_ = type();
+		set( (Int)value );
 	}
 
-	Value( const float &value )
+	Value( const float &value ) :
+		type_( Type::None )
 	{
-		data_ = (Float)value;
-		type_ = type();
+		set( (Float)value );
 	}
 
 	/**
 	 * @brief Value swap
 	 */
-	void swap( Value &rhs );
-	void swap( Value &&rhs );
+	void swap( Value &rhs ) noexcept;
+	void swap( Value &&rhs ) noexcept;
 
 	/**
 	 * @brief Assignment operators
 	 */
 	Value& operator=( const Value &value );
+	Value& operator=( Value &&value ) noexcept;
 	Value& operator=( const char *value );
 	Value& operator=( const int32_t &value );
 	Value& operator=( const uint32_t &value );
@@ -127,8 +169,19 @@ public:
 									  std::is_same<T, Object>::value>::type* = nullptr>
 	Value& operator=( const T &value )
 	{
-		data_ = value;
-		type_ = type();
+		Value tmp( value );
+		swap( tmp );
+		return *this;
+	}
+
+	template<typename T,
+			 typename std::enable_if <std::is_same<T, String>::value   ||
+									  std::is_same<T, Array>::value    ||
+									  std::is_same<T, Object>::value>::type* = nullptr>
+	Value& operator=( T &&value )
+	{
+		Value tmp( std::move( value ) );
+		swap( tmp );
 		return *this;
 	}
 
@@ -139,12 +192,11 @@ public:
 			 typename std::enable_if<std::is_same<T, None>::value     ||
 									 std::is_same<T, Int>::value      ||
 									 std::is_same<T, Float>::value    ||
-									 std::is_same<T, Bool>::value     ||
-									 std::is_same<T, String>::value>::type* = nullptr>
+									 std::is_same<T, Bool>::value>::type* = nullptr>
 	bool operator==( const T &value ) const
 	{
-		auto p_data = data_.get<T>();
-		return is<T>() && p_data && value == *p_data;
+		auto p_data = ptr( (const T*)nullptr );
+		return p_data && value == *p_data;
 	}
 
 	bool operator==( const int32_t &value ) const;
@@ -152,9 +204,19 @@ public:
 	bool operator==( const uint64_t &value ) const;
 	bool operator==( const float &value ) const;
 
+	bool operator==( const String &value ) const;
 	bool operator==( const char *value ) const;
 	bool operator==( const Value &value ) const;
 
+	/**
+	 * hash Returns structural hash, equal values have equal hashes. Hash doesn't depend on process
+	 * or run, arrays are hashed in element order, objects independently of member order.
+	 * Floating point numbers in [-1, 1] share one hash, since those compare equal within epsilon.
+	 * Hashes of arrays, objects and long strings are cached in their payload until it is modified.
+	 * @return Hash value.
+	 */
+	uint64_t hash() const;
+
 	template <typename T>
 	bool operator!=( const T &value ) const
 	{
@@ -176,6 +238,7 @@ public:
 
 	/**
 	 * at Returns an element by specified index or Null object if no such element.
+	 * Null object of mutable lookups is owned by calling thread and reset by its next failed lookup.
 	 * @param index Element index.
 	 * @return Object reference.
 	 */
@@ -211,9 +274,12 @@ public:
 	const Value& operator[]( const std::string &key ) const;
 	Value& operator[]( const char *key );
 	const Value& operator[]( const char *key ) const;
+	Value& operator[]( const StringRef &key );
+	const Value& operator[]( const StringRef &key ) const;
 
 	/**
 	 * at Returns an element by key or Null object if no such element.
+	 * Lookups of existing keys don't allocate, regardless of key type.
 	 * @param key Element key.
 	 * @return Object reference.
 	 */
@@ -221,6 +287,8 @@ public:
 	const Value& at( const std::string &key ) const;
 	Value& at( const char *key );
 	const Value& at( const char *key ) const;
+	Value& at( const StringRef &key );
+	const Value& at( const StringRef &key ) const;
 
 	/**
 	 * insert Adds a new element into object.
@@ -251,49 +319,54 @@ public:
 									  std::is_same<T, Object>::value>::type* = nullptr>
 	bool is() const
 	{
-		const T* ptr = nullptr;
-		return type( ptr ) == type_;
+		return type( (const T*)nullptr ) == type_;
 	}
 
 	inline bool is_none() const
 	{
-		return data_.type_index() < 2;
+		return type_ == Type::None;
 	}
 	inline bool is_bool() const
 	{
-		return data_.type_index() == 2;
+		return type_ == Type::Bool;
 	}
 	inline bool is_int() const
 	{
-		return data_.type_index() == 3;
+		return type_ == Type::Int;
 	}
 	inline bool is_float() const
 	{
-		return data_.type_index() == 4;
+		return type_ == Type::Float;
 	}
 	inline bool is_string() const
 	{
-		return data_.type_index() == 5;
+		return type_ == Type::String;
 	}
 	inline bool is_array() const
 	{
-		return data_.type_index() == 6;
+		return type_ == Type::Array;
 	}
 	inline bool is_object() const
 	{
-		return data_.type_index() == 7;
+		return type_ == Type::Object;
 	}
 
 	/**
 	 * get Get value by specific type. Or empty value if type don't match.
+	 * Empty value is owned by calling thread and reset by its next get() of the same type.
 	 * @return Value reference by type.
 	 */
 	template <typename T>
 	T& get()
 	{
-		static T t = default_value<T>();
-		auto v = data_.get<T>();
-		return v ? *v : t;
+		auto v = ptr( (T*)nullptr );
+		if ( v )
+		{
+			return *v;
+		}
+		static thread_local T t;
+		t = default_value<T>();
+		return t;
 	}
 
 	inline Int& get_int()
@@ -323,12 +396,13 @@ public:
 
 	/**
 	 * get Get value by specific type. Or empty value if type don't match.
+	 * Strings are deprecated here, see get_string() const.
 	 * @return Constant value reference by type.
 	 */
 	template <typename T>
 	const T& get() const
 	{
-		auto v = data_.get<T>();
+		auto v = ptr( (const T*)nullptr );
 		return v ? *v : default_value<T>();
 	}
 
@@ -344,9 +418,34 @@ public:
 	{
 		return get<Bool>();
 	}
+	/**
+	 * get_string Returns string reference. Short strings are kept in the value cell rather than
+	 * in std::string, so they are copied into one of a few slots owned by calling thread,
+	 * and the reference stays valid only until that thread copies a few more of them.
+	 * Use string_ref() to read in place, or as_string() for a copy.
+	 * @return String reference, empty string if value is not a string.
+	 */
+	JSONCPP_DEPRECATED( "short strings are copied into per-thread slots, use string_ref() or as_string()" )
 	inline const String& get_string() const
 	{
-		return get<String>();
+		return string_value();
+	}
+
+	/**
+	 * string_ref Returns string contents without copying.
+	 * @return String reference, empty if value is not a string.
+	 */
+	StringRef string_ref() const
+	{
+		if ( type_ != Type::String )
+		{
+			return StringRef();
+		}
+		if ( is_small() )
+		{
+			return StringRef( cell_, (uint8_t)cell_[small_capacity_] );
+		}
+		return StringRef( data().string_->value );
 	}
 	inline const Array& get_array() const
 	{
@@ -379,24 +478,13 @@ public:
 	 * type Returns value type.
 	 * @return Value type.
 	 */
-	template<typename T>
-	Type type( const T *v ) const
-	{
-		static struct
-		{
-			Value::Type t = Value::Type::None;
-			void operator()( const None* )   { t = Type::None;   }
-			void operator()( const Int* )    { t = Type::Int;    }
-			void operator()( const Float* )  { t = Type::Float;  }
-			void operator()( const Bool* )   { t = Type::Bool;   }
-			void operator()( const String* ) { t = Type::String; }
-			void operator()( const Array* )  { t = Type::Array;  }
-			void operator()( const Object* ) { t = Type::Object; }
-		} visitor;
-
-		data_.accept( v, visitor );
-		return visitor.t;
-	}
+	static constexpr Type type( const None* )   { return Type::None;   }
+	static constexpr Type type( const Int* )    { return Type::Int;    }
+	static constexpr Type type( const Float* )  { return Type::Float;  }
+	static constexpr Type type( const Bool* )   { return Type::Bool;   }
+	static constexpr Type type( const String* ) { return Type::String; }
+	static constexpr Type type( const Array* )  { return Type::Array;  }
+	static constexpr Type type( const Object* ) { return Type::Object; }
 
 	/**
 	 * type Returns current object type.
@@ -404,6 +492,13 @@ public:
 	 */
 	Type type() const;
 
+	/**
+	 * resource Returns memory resource of the value payload.
+	 * Copies allocate from the same resource, inserted values are moved into container resource.
+	 * @return Resource pointer, default resource for values without allocated payload.
+	 */
+	MemoryResource* resource() const;
+
 	/**
 	 * accept Call corresponding method of specified visitor.
 	 */
@@ -443,6 +538,7 @@ public:
 	 * @return True if index exists.
 	 */
 	bool has( unsigned index ) const;
+	bool has( int index ) const;
 
 	/**
 	 * index Checks if element exists in array using specified predicate
@@ -451,10 +547,12 @@ public:
 	bool find( ElementPredicate pred, unsigned &index ) const;
 
 	/**
-	 * has Checks if key exists in array.
+	 * has Checks if key exists in object.
 	 * @return True if key exists.
 	 */
 	bool has( const std::string &key ) const;
+	bool has( const char *key ) const;
+	bool has( const StringRef &key ) const;
 
 	/**
 	 * is_convertable Checks if value is convertable into specified type.
@@ -474,12 +572,12 @@ public:
 	 */
 	inline Int as_int64() const
 	{
-		return as( Value::Type::Int ).get_int();
+		return to_int();
 	}
 
 	inline Int as_int() const
 	{
-		return as( Value::Type::Int ).get_int();
+		return to_int();
 	}
 
 	/**
@@ -506,7 +604,7 @@ public:
 	 */
 	inline Float as_double() const
 	{
-		return as( Value::Type::Float ).get_float();
+		return to_float();
 	}
 
 	/**
@@ -515,7 +613,7 @@ public:
 	 */
 	inline Bool as_bool() const
 	{
-		return as( Value::Type::Bool ).get_bool();
+		return to_bool();
 	}
 
 	/**
@@ -524,38 +622,193 @@ public:
 	 */
 	inline String as_string() const
 	{
-		return as( Value::Type::String ).get_string();
+		return is_string() ? string_ref().str() : as( Value::Type::String ).get_string();
 	}
 
 	/**
 	 * as_array Returns value as array.
-	 * @return Array value.
+	 * @return Array reference, empty array if value is not an array.
 	 */
-	inline Array as_array() const
+	inline const Array& as_array() const
 	{
-		return as( Value::Type::Array ).get_array();
+		return get_array();
 	}
 
 	/**
 	 * as_object Returns value as object.
-	 * @return Object value.
+	 * @return Object reference, empty object if value is not an object.
 	 */
-	inline Object as_object() const
+	inline const Object& as_object() const
 	{
-		return as( Value::Type::Object ).get_object();
+		return get_object();
+	}
+
+	/**
+	 * try_get Converts value in a single pass, without allocating for numeric targets.
+	 * Strings are parsed strictly and independently of current locale: integers as [+-]digits,
+	 * floating point numbers as decimal with optional fraction and exponent, booleans as
+	 * true/false/1/0 in any case. Out of range numbers are not converted.
+	 * @param out Converted value, unchanged on failure.
+	 * @return True if value was converted.
+	 */
+	bool try_get( Int &out ) const;
+	bool try_get( int32_t &out ) const;
+	bool try_get( uint32_t &out ) const;
+	bool try_get( uint64_t &out ) const;
+	bool try_get( Float &out ) const;
+	bool try_get( float &out ) const;
+	bool try_get( Bool &out ) const;
+	bool try_get( String &out ) const;
+
+	/**
+	 * try_as Converts value like try_get().
+	 * @return Pair of success flag and converted value, or default value on failure.
+	 */
+	template <typename T>
+	std::pair<bool, T> try_as() const
+	{
+		T t = T();
+		bool ok = try_get( t );
+		return std::make_pair( ok, t );
 	}
 
 private:
+	friend class JsonImpl;
+
+	/**
+	 * @brief Heap allocated reference counted payload, remembers resource it came from.
+	 */
+	template <typename T>
+	struct Box
+	{
+		MemoryResource *resource;
+		std::atomic<uint32_t> refs;
+		bool shareable; // False once mutable reference to value was handed out
+		std::atomic<uint64_t> hash; // Cached hash() while shareable, zero if not known
+		T value;
+
+		template <typename ...Args>
+		Box( MemoryResource *resource, Args&&... args ) :
+			resource( resource ),
+			refs( 1 ),
+			shareable( true ),
+			hash( 0 ),
+			value( std::forward<Args>( args )... )
+		{}
+	};
+
+	/**
+	 * @brief Value cell payload, interpreted according to type_.
+	 */
+	union Payload
+	{
+		Int          int_;
+		Float        float_;
+		Bool         bool_;
+		Box<String> *string_;
+		Box<Array>  *array_;
+		Box<Object> *object_;
+	};
+
+	/**
+	 * Strings up to this length are stored in the cell itself, with length in the last cell byte.
+	 */
+	static constexpr size_t small_capacity_ = 14;
+	static constexpr uint8_t heap_string_ = 0xFF;
+
+	alignas( Payload ) char cell_[small_capacity_ + 1];
 	Type type_;
-	Variant<
-		None,
-		Bool,
-		Int,
-		Float,
-		String,
-		Array,
-		Object
-	> data_;
+
+	inline Payload& data()
+	{
+		return *reinterpret_cast<Payload*>( cell_ );
+	}
+	inline const Payload& data() const
+	{
+		return *reinterpret_cast<const Payload*>( cell_ );
+	}
+	inline bool is_small() const
+	{
+		return type_ == Type::String && (uint8_t)cell_[small_capacity_] != heap_string_;
+	}
+
+	template <typename T, typename ...Args>
+	static Box<T>* make_box( MemoryResource *resource, Args&&... args );
+	template <typename T>
+	static void release_box( Box<T> *box );
+	template <typename T>
+	static bool share_box( Box<T> *box, MemoryResource *resource );
+
+	void detach();
+	Array& array_ref();
+	Object& object_ref();
+
+	// Returns cached hash of payload, computing it if unknown
+	template <typename T>
+	uint64_t box_hash( Box<T> *box ) const;
+	// Payloads with known hashes are only equal if the hashes are
+	template <typename T>
+	static bool hash_differs( const Box<T> *lhs, const Box<T> *rhs );
+	uint64_t compute_hash() const;
+
+	// Scalar conversions, same as as( t ).get<T>() without temporary value
+	Int to_int() const;
+	Float to_float() const;
+	Bool to_bool() const;
+	// Returns zero terminated string contents, inline strings are copied into buffer
+	const char* c_str( char (&buffer)[small_capacity_ + 1] ) const;
+	// Returns heap string, inline strings are copied into a slot owned by calling thread
+	const String& string_value() const;
+
+	void set( const None& );
+	void set( const Int &value );
+	void set( const Float &value );
+	void set( const Bool &value );
+	void set( const String &value );
+	void set( const Array &value );
+	void set( const Object &value );
+	void set( String &&value );
+	void set( Array &&value );
+	void set( Object &&value );
+	void set( const char *s, size_t n, MemoryResource *resource );
+	void set( String &&value, MemoryResource *resource );
+	void set( const Array &value, MemoryResource *resource );
+	void set( const Object &value, MemoryResource *resource );
+
+	inline const None* ptr( const None* ) const
+	{
+		static const None null = nullptr;
+		return type_ == Type::None ? &null : nullptr;
+	}
+	inline const Int* ptr( const Int* ) const
+	{
+		return type_ == Type::Int ? &data().int_ : nullptr;
+	}
+	inline const Float* ptr( const Float* ) const
+	{
+		return type_ == Type::Float ? &data().float_ : nullptr;
+	}
+	inline const Bool* ptr( const Bool* ) const
+	{
+		return type_ == Type::Bool ? &data().bool_ : nullptr;
+	}
+	inline const Array* ptr( const Array* ) const
+	{
+		return type_ == Type::Array ? &data().array_->value : nullptr;
+	}
+	inline const Object* ptr( const Object* ) const
+	{
+		return type_ == Type::Object ? &data().object_->value : nullptr;
+	}
+
+	template <typename T>
+	inline T* ptr( T* )
+	{
+		return const_cast<T*>( static_cast<const Value*>( this )->ptr( (const T*)nullptr ) );
+	}
+	String* ptr( String* );
+	Array* ptr( Array* );
+	Object* ptr( Object* );
 
 	static const Int    default_int_;
 	static const Float  default_float_;
@@ -573,6 +826,20 @@ private:
 };
 
 
+static_assert( sizeof( Value ) <= 16, "Value cell must fit in 16 bytes" );
+
+template <>
+JSONCPP_DEPRECATED( "short strings are copied into per-thread slots, use string_ref() or as_string()" )
+inline const Value::String& Value::get<Value::String>() const
+{
+	return string_value();
+}
+
+inline void swap( Value &lhs, Value &rhs ) noexcept
+{
+	lhs.swap( rhs );
+}
+
 template<typename T>
 bool operator==( const T &lhs, const Value &rhs )
 {
@@ -584,3 +851,17 @@ bool operator<( const Value::Type lhs, const Value::Type rhs );
 const char* to_string( Value::Type type );
 
 } // namespace jsoncpp
+
+namespace std
+{
+
+template <>
+struct hash<jsoncpp::Value>
+{
+	size_t operator()( const jsoncpp::Value &value ) const
+	{
+		return (size_t)value.hash();
+	}
+};
+
+} // namespace std
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace jsoncpp
 {
@@ -40,8 +44,18 @@ struct TypeIndex<T, T, Ts...> : std::integral_constant<unsigned, 1>{};
 template <typename T1, typename T2, typename ...Ts>
 struct TypeIndex<T1, T2, Ts...> : std::integral_constant<unsigned, 1 + TypeIndex<T1, Ts...>::value>{};
 
+/**
+ * First type of a parameter pack
+ */
+template <typename T, typename ...Ts>
+struct FirstType
+{
+	typedef T type;
+};
+
 /**
  * Variant class
+ * Copy, move, destroy and visit operations are dispatched through static tables indexed by type.
  */
 
 template <typename ...Types>
@@ -49,32 +63,37 @@ class Variant
 {
 public:
 	Variant() :
-		type_( invalid_type_ ),
-		destructor_( nullptr ),
-		copier_( nullptr )
+		type_( invalid_type_ )
 	{}
 	Variant( const Variant &v ) :
-		type_( invalid_type_ ),
-		destructor_( nullptr ),
-		copier_( nullptr )
+		type_( invalid_type_ )
 	{
 		clone( v );
 	}
 	Variant( Variant &v ) :
-		type_( invalid_type_ ),
-		destructor_( nullptr ),
-		copier_( nullptr )
+		type_( invalid_type_ )
 	{
 		clone( v );
 	}
+	Variant( Variant &&v ) noexcept :
+		type_( invalid_type_ )
+	{
+		take( v );
+	}
 	template <class T>
 	Variant( const T &value ) :
-		type_( invalid_type_ ),
-		destructor_( nullptr ),
-		copier_( nullptr )
+		type_( invalid_type_ )
 	{
 		build( value );
 	}
+	template <class T,
+			  typename std::enable_if<!std::is_reference<T>::value &&
+									  !std::is_same<typename std::decay<T>::type, Variant>::value>::type* = nullptr>
+	Variant( T &&value ) :
+		type_( invalid_type_ )
+	{
+		build( std::move( value ) );
+	}
 
 	~Variant()
 	{
@@ -87,19 +106,37 @@ public:
 		return *this;
 	}
 
-	Variant& operator=( const Variant &&v )
+	Variant& operator=( Variant &&v ) noexcept
 	{
-		clone( std::move( v ) );
+		take( v );
 		return *this;
 	}
 
+	// Argument may refer into current contents, so it is consumed before they are destroyed
 	template <class T>
 	Variant& set( const T &v )
 	{
-		clone( v );
+		Variant tmp( v );
+		take( tmp );
 		return *this;
 	}
 
+	template <class T,
+			  typename std::enable_if<!std::is_reference<T>::value>::type* = nullptr>
+	Variant& set( T &&v )
+	{
+		Variant tmp( std::move( v ) );
+		take( tmp );
+		return *this;
+	}
+
+	void swap( Variant &v ) noexcept
+	{
+		Variant tmp( std::move( v ) );
+		v.take( *this );
+		take( tmp );
+	}
+
 	template <class T>
 	bool is()
 	{
@@ -129,7 +166,7 @@ public:
 	{
 		if ( type_ )
 		{
-			destructor_( &data_ );
+			destructors_[type_ - 1]( &data_ );
 			type_ = invalid_type_;
 		}
 	}
@@ -142,7 +179,24 @@ public:
 	template <class Visitor>
 	void accept( Visitor &v ) const
 	{
-		Dispatcher<Visitor, Types...>::dispatch( *this, v );
+		visit( v );
+	}
+
+	/**
+	 * visit Calls visitor for contained value, or without arguments if empty.
+	 * @return Visitor result.
+	 */
+	template <class Visitor>
+	auto visit( Visitor &v ) const -> decltype( v( std::declval<const typename FirstType<Types...>::type&>() ) )
+	{
+		typedef decltype( v( std::declval<const typename FirstType<Types...>::type&>() ) ) Result;
+		typedef Result (*Call)( const void*, Visitor& );
+		static const Call table[] = { &Ops<Types>::template call<Visitor, Result>... };
+		if ( type_ == invalid_type_ )
+		{
+			return v();
+		}
+		return table[type_ - 1]( &data_, v );
 	}
 
 	template <typename T, class Visitor>
@@ -152,62 +206,51 @@ public:
 	}
 
 private:
-	template <typename Visitor, typename ...Ts>
-	struct Dispatcher;
-
-	template <typename Visitor>
-	struct Dispatcher<Visitor>
+	template <typename T>
+	struct Ops
 	{
-		static void dispatch( const Variant&, Visitor &visitor )
+		static void copy( const void *src, void *dst )
 		{
-			visitor();
+			new( dst ) T( *reinterpret_cast<const T*>( src ) );
 		}
-	};
-
-	template <typename Visitor, typename T, typename ...Ts>
-	struct Dispatcher<Visitor, T, Ts...>
-	{
-		static void dispatch( const Variant &v, Visitor &visitor )
+		static void move( void *src, void *dst ) noexcept
 		{
-			const T *value = v.get<T>();
-			if ( value )
-			{
-				visitor.operator()( *value );
-			}
-			else
-			{
-				Dispatcher<Visitor, Ts...>::dispatch( v, visitor );
-			}
+			new( dst ) T( std::move( *reinterpret_cast<T*>( src ) ) );
+			reinterpret_cast<T*>( src )->~T();
+		}
+		static void destroy( void *data ) noexcept
+		{
+			reinterpret_cast<T*>( data )->~T();
+		}
+		template <typename Visitor, typename Result>
+		static Result call( const void *data, Visitor &v )
+		{
+			return v( *reinterpret_cast<const T*>( data ) );
 		}
 	};
 
+	typedef void (*Copier)( const void*, void* );
+	typedef void (*Mover)( void*, void* );
+	typedef void (*Destructor)( void* );
+
+	static const Copier copiers_[sizeof...( Types )];
+	static const Mover movers_[sizeof...( Types )];
+	static const Destructor destructors_[sizeof...( Types )];
+
 	static constexpr auto data_size_ = Max<size_t, sizeof(Types)...>::value;
 	static constexpr auto data_align_ = Max<size_t, alignof(Types)...>::value;
 	static constexpr unsigned invalid_type_ = 0;
+	static_assert( sizeof...( Types ) < 255, "Too many variant types" );
 	typedef typename std::aligned_storage<data_size_, data_align_>::type DataType;
 	DataType data_;
-	unsigned type_;
-	void (*destructor_)( void* );
-	void (*copier_)( const void*, void* );
+	uint8_t type_;
 
-	template <typename T>
-	void build( const T &value )
+	template <typename U>
+	void build( U &&value )
 	{
-		struct Util
-		{
-			static void copy( const void *src, void *dst )
-			{
-				new( reinterpret_cast<T*>( dst ) ) T( *reinterpret_cast<const T*>( src ) );
-			}
-			static void destroy( void *data )
-			{
-				reinterpret_cast<T*>( data )->~T();
-			}
-		};
+		typedef typename std::decay<U>::type T;
+		new( reinterpret_cast<T*>( &data_ ) ) T( std::forward<U>( value ) );
 		type_ = TypeIndex<T, Types...>::value;
-		destructor_ = &Util::destroy;
-		copier_ = &Util::copy;
-		Util::copy( &value, &data_ );
 	}
 
 	void clone( const Variant &value )
@@ -216,24 +259,38 @@ private:
 		clear();
 		if ( value.type_ )
 		{
-			value.copier_( &value.data_, &data_ );
+			copiers_[value.type_ - 1]( &value.data_, &data_ );
 			type_ = value.type_;
-			destructor_ = value.destructor_;
-			copier_ = value.copier_;
 		}
 	}
 
-	void clone( const Variant &&value )
+	// Moves contents, leaving source empty
+	void take( Variant &value ) noexcept
 	{
+		if ( this == &value ) { return; }
 		clear();
 		if ( value.type_ )
 		{
-			value.copier_( &value.data_, &data_ );
+			movers_[value.type_ - 1]( &value.data_, &data_ );
 			type_ = value.type_;
-			destructor_ = value.destructor_;
-			copier_ = value.copier_;
+			value.type_ = invalid_type_;
 		}
 	}
 };
 
+template <typename ...Types>
+const typename Variant<Types...>::Copier Variant<Types...>::copiers_[sizeof...( Types )] = { &Variant<Types...>::Ops<Types>::copy... };
+
+template <typename ...Types>
+const typename Variant<Types...>::Mover Variant<Types...>::movers_[sizeof...( Types )] = { &Variant<Types...>::Ops<Types>::move... };
+
+template <typename ...Types>
+const typename Variant<Types...>::Destructor Variant<Types...>::destructors_[sizeof...( Types )] = { &Variant<Types...>::Ops<Types>::destroy... };
+
+template <typename ...Types>
+inline void swap( Variant<Types...> &lhs, Variant<Types...> &rhs ) noexcept
+{
+	lhs.swap( rhs );
+}
+
 } // namespace jsoncpp
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <utility>
+#include "frozen.hpp"
+
+namespace jsoncpp
+{
+
+const FrozenValue::Node FrozenValue::none_ = {};
+
+// Compares keys as unsigned bytes, same order as std::string
+static bool key_less( const StringRef &lhs, const StringRef &rhs )
+{
+	int r = std::memcmp( lhs.data(), rhs.data(), std::min( lhs.size(), rhs.size() ) );
+	return r < 0 || ( r == 0 && lhs.size() < rhs.size() );
+}
+
+FrozenValue::FrozenValue() :
+	base_( nullptr ),
+	node_( &none_ )
+{}
+
+FrozenValue FrozenValue::operator[]( size_t index ) const
+{
+	if ( index >= node_->size )
+	{
+		return FrozenValue();
+	}
+	switch( type() )
+	{
+		case Value::Type::Array:  return FrozenValue( base_, child( index ) );
+		case Value::Type::Object: return FrozenValue( base_, child( node_->size + index ) );
+		default:                  return FrozenValue();
+	}
+}
+
+FrozenValue FrozenValue::operator[]( const StringRef &key ) const
+{
+	if ( !is_object() )
+	{
+		return FrozenValue();
+	}
+	size_t first = 0;
+	size_t count = node_->size;
+	while( count > 0 )
+	{
+		size_t step = count / 2;
+		const Node *k = child( first + step );
+		if ( key_less( StringRef( base_ + k->offset_, k->size ), key ) )
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+	if ( first < node_->size && this->key( first ) == key )
+	{
+		return FrozenValue( base_, child( node_->size + first ) );
+	}
+	return FrozenValue();
+}
+
+bool FrozenValue::has( const StringRef &key ) const
+{
+	return (*this)[key].node_ != &none_;
+}
+
+StringRef FrozenValue::key( size_t index ) const
+{
+	if ( !is_object() || index >= node_->size )
+	{
+		return StringRef();
+	}
+	const Node *k = child( index );
+	return StringRef( base_ + k->offset_, k->size );
+}
+
+Value::Int FrozenValue::as_int() const
+{
+	switch( type() )
+	{
+		case Value::Type::Int:   return node_->int_;
+		case Value::Type::Float: return (Value::Int)node_->float_;
+		case Value::Type::Bool:  return node_->bool_ ? 1 : 0;
+		default:                 return 0;
+	}
+}
+
+Value::Float FrozenValue::as_double() const
+{
+	switch( type() )
+	{
+		case Value::Type::Int:   return (Value::Float)node_->int_;
+		case Value::Type::Float: return node_->float_;
+		case Value::Type::Bool:  return node_->bool_ ? 1.0 : 0.0;
+		default:                 return 0.0;
+	}
+}
+
+Value::Bool FrozenValue::as_bool() const
+{
+	switch( type() )
+	{
+		case Value::Type::Int:   return node_->int_ != 0;
+		case Value::Type::Float: return node_->float_ != 0.0;
+		case Value::Type::Bool:  return node_->bool_;
+		default:                 return false;
+	}
+}
+
+StringRef FrozenValue::string_ref() const
+{
+	return is_string() ? StringRef( base_ + node_->offset_, node_->size ) : StringRef();
+}
+
+Value FrozenValue::thaw() const
+{
+	switch( type() )
+	{
+		case Value::Type::Int:    return Value( node_->int_ );
+		case Value::Type::Float:  return Value( node_->float_ );
+		case Value::Type::Bool:   return Value( node_->bool_ );
+		case Value::Type::String: return Value( string_ref().str() );
+		// Containers are filled before they are moved in, so their payloads stay shareable
+		case Value::Type::Array:
+		{
+			Value::Array a;
+			a.reserve( size() );
+			for( size_t i = 0; i < size(); i++ )
+			{
+				a.push_back( (*this)[i].thaw() );
+			}
+			return Value( std::move( a ) );
+		}
+		case Value::Type::Object:
+		{
+			Value::Object o;
+			for( size_t i = 0; i < size(); i++ )
+			{
+				o.emplace( key( i ).str(), (*this)[i].thaw() );
+			}
+			return Value( std::move( o ) );
+		}
+		default:
+			return Value();
+	}
+}
+
+/**
+ * @brief Packs value tree into buffer. Record and character counts are measured first,
+ * so buffer is allocated once. Records come first, followed by zero terminated characters.
+ */
+class FrozenDocument::Builder
+{
+public:
+	Builder( std::vector<Node> &buffer ) :
+		buffer_( buffer ),
+		next_node_( 1 ),
+		next_char_( 0 )
+	{}
+
+	void build( const Value &value )
+	{
+		size_t nodes = 1;
+		size_t chars = 0;
+		measure( value, nodes, chars );
+		buffer_.assign( nodes + ( chars + sizeof( Node ) - 1 ) / sizeof( Node ), Node() );
+		next_char_ = nodes * sizeof( Node );
+		write( value, 0 );
+	}
+
+private:
+	std::vector<Node> &buffer_;
+	size_t next_node_; // Index of next free record
+	size_t next_char_; // Byte offset of next free character
+	std::vector<std::pair<StringRef, const Value*> > members_; // Sort space, shared by nested objects
+
+	static void measure( const Value &value, size_t &nodes, size_t &chars )
+	{
+		switch( value.type() )
+		{
+			case Value::Type::String:
+				chars += value.string_ref().size() + 1;
+				break;
+			case Value::Type::Array:
+				nodes += value.size();
+				for( auto &element : value.get_array() )
+				{
+					measure( element, nodes, chars );
+				}
+				break;
+			case Value::Type::Object:
+				nodes += 2 * value.size();
+				for( auto &member : value.get_object() )
+				{
+					const std::string &key = member.first;
+					chars += key.size() + 1;
+					measure( member.second, nodes, chars );
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	char* chars()
+	{
+		return reinterpret_cast<char*>( buffer_.data() );
+	}
+
+	void write( const StringRef &s, size_t at )
+	{
+		Node &node = buffer_[at];
+		node.type = (uint8_t)Value::Type::String;
+		node.size = s.size();
+		node.offset_ = next_char_;
+		std::memcpy( chars() + next_char_, s.data(), s.size() );
+		next_char_ += s.size() + 1;
+	}
+
+	void write( const Value &value, size_t at )
+	{
+		buffer_[at].type = (uint8_t)value.type();
+		switch( value.type() )
+		{
+			case Value::Type::Int:
+				buffer_[at].int_ = value.get_int();
+				break;
+			case Value::Type::Float:
+				buffer_[at].float_ = value.get_float();
+				break;
+			case Value::Type::Bool:
+				buffer_[at].bool_ = value.get_bool();
+				break;
+			case Value::Type::String:
+				write( value.string_ref(), at );
+				break;
+			case Value::Type::Array:
+			{
+				auto &a = value.get_array();
+				size_t first = reserve( at, a.size(), a.size() );
+				for( size_t i = 0; i < a.size(); i++ )
+				{
+					write( a[i], first + i );
+				}
+				break;
+			}
+			case Value::Type::Object:
+			{
+				auto &o = value.get_object();
+				size_t first = reserve( at, o.size(), 2 * o.size() );
+				size_t begin = members_.size();
+				for( auto &member : o )
+				{
+					const std::string &key = member.first;
+					members_.emplace_back( StringRef( key ), &member.second );
+				}
+				std::sort( members_.begin() + begin, members_.end(),
+					[]( const std::pair<StringRef, const Value*> &lhs, const std::pair<StringRef, const Value*> &rhs )
+					{
+						return key_less( lhs.first, rhs.first );
+					} );
+				for( size_t i = 0; i < o.size(); i++ )
+				{
+					write( members_[begin + i].first, first + i );
+				}
+				for( size_t i = 0; i < o.size(); i++ )
+				{
+					// Nested objects may grow sort space, so it is indexed rather than iterated
+					write( *members_[begin + i].second, first + o.size() + i );
+				}
+				members_.resize( begin );
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	// Allocates block of child records, returns index of the first one
+	size_t reserve( size_t at, size_t size, size_t count )
+	{
+		size_t first = next_node_;
+		next_node_ += count;
+		buffer_[at].size = size;
+		buffer_[at].offset_ = first * sizeof( Node );
+		return first;
+	}
+};
+
+FrozenDocument::FrozenDocument() :
+	buffer_( 1, Node() )
+{}
+
+FrozenDocument::FrozenDocument( const Value &value )
+{
+	Builder( buffer_ ).build( value );
+}
+
+FrozenValue FrozenDocument::root() const
+{
+	return FrozenValue( reinterpret_cast<const char*>( buffer_.data() ), buffer_.data() );
+}
+
+size_t FrozenDocument::size() const
+{
+	return buffer_.size() * sizeof( Node );
+}
+
+} // namespace jsoncpp
@@ -2,8 +2,16 @@
 #include <cstring>
 #include <cstdio>
 #include <stack>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <utility>
+#include <exception>
 #include <errno.h>
+#include <inttypes.h>
 #include "json.hpp"
 
 
@@ -191,6 +199,476 @@ private:
 	}
 };
 
+/**
+ * Output policy, which only counts serialized bytes.
+ */
+class JsonCounter
+{
+public:
+	void put( char )
+	{
+		size_++;
+	}
+
+	void put( const char*, size_t n )
+	{
+		size_ += n;
+	}
+
+	void fill( size_t n, char )
+	{
+		size_ += n;
+	}
+
+	void reserve( size_t )
+	{}
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+private:
+	size_t size_ = 0;
+};
+
+/**
+ * Output policy, which appends serialized bytes to a string.
+ */
+class JsonStringOutput
+{
+public:
+	JsonStringOutput( std::string &s ) :
+		s_( s )
+	{}
+
+	void put( char c )
+	{
+		s_ += c;
+	}
+
+	void put( const char *p, size_t n )
+	{
+		s_.append( p, n );
+	}
+
+	void fill( size_t n, char c )
+	{
+		s_.append( n, c );
+	}
+
+	// Makes room for n more bytes
+	void reserve( size_t n )
+	{
+		s_.reserve( s_.size() + n );
+	}
+
+private:
+	std::string &s_;
+};
+
+/**
+ * Output policy, which collects segments for scatter-gather output.
+ * Buffer may reallocate while building, so buffer segments are kept as offsets until finish().
+ */
+class JsonSegmentOutput
+{
+public:
+	JsonSegmentOutput( Json::Segments &segments ) :
+		segments_( segments )
+	{}
+
+	void put( char c )
+	{
+		segments_.buffer += c;
+	}
+
+	void put( const char *p, size_t n )
+	{
+		segments_.buffer.append( p, n );
+	}
+
+	void fill( size_t n, char c )
+	{
+		segments_.buffer.append( n, c );
+	}
+
+	void reserve( size_t n )
+	{
+		segments_.buffer.reserve( segments_.buffer.size() + n );
+	}
+
+	/**
+	 * reference Adds segment, which points to external data.
+	 */
+	void reference( const char *p, size_t n )
+	{
+		if ( n < segments_.min_reference_size )
+		{
+			put( p, n );
+			return;
+		}
+		cut();
+		pending_.push_back( Segment{ p, 0, n } );
+	}
+
+	size_t min_reference_size() const
+	{
+		return segments_.min_reference_size;
+	}
+
+	void finish()
+	{
+		cut();
+		segments_.iov.clear();
+		segments_.iov.reserve( pending_.size() );
+		for( auto &i : pending_ )
+		{
+			auto base = i.data ? i.data : &segments_.buffer[i.offset];
+			segments_.iov.push_back( iovec{ const_cast<char*>( base ), i.size } );
+		}
+	}
+
+private:
+	struct Segment
+	{
+		const char *data; // nullptr for buffer segments
+		size_t offset;
+		size_t size;
+	};
+	Json::Segments &segments_;
+	std::vector<Segment> pending_;
+	size_t cut_ = 0;
+
+	// Turns buffer contents written since the previous cut into a segment
+	void cut()
+	{
+		if ( segments_.buffer.size() > cut_ )
+		{
+			pending_.push_back( Segment{ nullptr, cut_, segments_.buffer.size() - cut_ } );
+			cut_ = segments_.buffer.size();
+		}
+	}
+};
+
+/**
+ * Writes quoted and escaped string into the output policy.
+ */
+template <class Output>
+void json_escape( Output &out, const StringRef &s )
+{
+	out.put( '\"' );
+	const char *p = s.data();
+	const char *end = p + s.size();
+	const char *chunk = p;
+	for( ; p < end; ++p )
+	{
+		const char *esc;
+		switch( *p )
+		{
+		case '\\': esc = "\\\\"; break;
+		case '\"': esc = "\\\""; break;
+		case '\b': esc = "\\b"; break;
+		case '\f': esc = "\\f"; break;
+		case '\n': esc = "\\n"; break;
+		case '\r': esc = "\\r"; break;
+		case '\t': esc = "\\t"; break;
+		default: continue;
+		}
+		out.put( chunk, p - chunk );
+		out.put( esc, 2 );
+		chunk = p + 1;
+	}
+	out.put( chunk, end - chunk );
+	out.put( '\"' );
+}
+
+/**
+ * Writes quoted and escaped string into segments, referencing long unescaped parts in place.
+ */
+void json_escape( JsonSegmentOutput &out, const StringRef &s )
+{
+	if ( s.size() < out.min_reference_size() )
+	{
+		json_escape<JsonSegmentOutput>( out, s );
+		return;
+	}
+	out.put( '\"' );
+	const char *p = s.data();
+	const char *end = p + s.size();
+	const char *chunk = p;
+	for( ; p < end; ++p )
+	{
+		const char *esc;
+		switch( *p )
+		{
+		case '\\': esc = "\\\\"; break;
+		case '\"': esc = "\\\""; break;
+		case '\b': esc = "\\b"; break;
+		case '\f': esc = "\\f"; break;
+		case '\n': esc = "\\n"; break;
+		case '\r': esc = "\\r"; break;
+		case '\t': esc = "\\t"; break;
+		default: continue;
+		}
+		out.reference( chunk, p - chunk );
+		out.put( esc, 2 );
+		chunk = p + 1;
+	}
+	out.reference( chunk, end - chunk );
+	out.put( '\"' );
+}
+
+/**
+ * Serializes values into the output policy.
+ * Any policy produces exactly the same byte sequence, so that JsonCounter result matches the built string length.
+ */
+template <class Output>
+class JsonSerializer
+{
+public:
+	JsonSerializer( Output &out, const Json::Format &f, bool parallel = false ) :
+		out_( out ),
+		f_( f ),
+		parallel_( parallel )
+	{}
+
+	void value( const Value &value, unsigned level )
+	{
+		switch( value.type() )
+		{
+		case Value::Type::None:
+			out_.put( "null", 4 );
+			break;
+		case Value::Type::Bool:
+			if ( value.get_bool() )
+			{
+				out_.put( "true", 4 );
+			}
+			else
+			{
+				out_.put( "false", 5 );
+			}
+			break;
+		case Value::Type::Int:
+		{
+			char buf[21];
+			int len = snprintf( buf, sizeof( buf ), "%" PRId64, value.get_int() );
+			out_.put( buf, len );
+			break;
+		}
+		case Value::Type::Float:
+		{
+			char buf[50];
+			int len = snprintf( buf, sizeof( buf ), "%g", value.get_float() );
+			out_.put( buf, len );
+			break;
+		}
+		case Value::Type::String:
+			string( value.string_ref() );
+			break;
+		case Value::Type::Array:
+			array( value.get_array(), level );
+			break;
+		case Value::Type::Object:
+			object( value.get_object(), level );
+			break;
+		}
+	}
+
+	/**
+	 * range Serializes container elements from begin to end.
+	 * @param last Container end, to find out the last element.
+	 */
+	template <class Iterator>
+	void range( Iterator begin, Iterator end, Iterator last, unsigned level )
+	{
+		for( auto it = begin; it != end; )
+		{
+			element( *it, level );
+			if ( ++it != last )
+			{
+				out_.put( ',' );
+			}
+			if ( f_.indent_size )
+			{
+				out_.put( '\n' );
+			}
+		}
+	}
+
+private:
+	Output &out_;
+	const Json::Format &f_;
+	bool parallel_;
+
+	void indent( unsigned level )
+	{
+		out_.fill( level * f_.indent_size, f_.indent_char );
+	}
+
+	void string( const StringRef &s )
+	{
+		json_escape( out_, s );
+	}
+
+	// Keys rarely need escaping, in which case they are copied with a single put()
+	void key( const std::string &k )
+	{
+		string( k );
+		separator();
+	}
+
+	// Pool keys are shared across values and parses, so they are escaped once and kept quoted
+	void key( const Key &k )
+	{
+		if ( !k.interned() )
+		{
+			key( k.str() );
+			return;
+		}
+		auto quoted = k.encoded();
+		if ( !quoted )
+		{
+			std::string s;
+			JsonStringOutput out( s );
+			json_escape( out, StringRef( k.str() ) );
+			quoted = &k.encode( std::move( s ) );
+		}
+		out_.put( quoted->data(), quoted->size() );
+		separator();
+	}
+
+	void separator()
+	{
+		out_.put( ':' );
+		if ( f_.indent_size )
+		{
+			out_.put( ' ' );
+		}
+	}
+
+	void array( const Value::Array &arr, unsigned level )
+	{
+		out_.put( '[' );
+		elements( arr, level );
+		out_.put( ']' );
+	}
+
+	void object( const Value::Object &obj, unsigned level )
+	{
+		out_.put( '{' );
+		elements( obj, level );
+		out_.put( '}' );
+	}
+
+	template <class Container>
+	void elements( const Container &c, unsigned level )
+	{
+		if ( f_.indent_size )
+		{
+			out_.put( '\n' );
+		}
+		if ( parallel_ && c.size() > 1 && c.size() >= f_.parallel_threshold )
+		{
+			parallel( c, level + 1 );
+		}
+		else
+		{
+			range( c.begin(), c.end(), c.end(), level + 1 );
+		}
+		indent( level );
+	}
+
+	void element( const Value &v, unsigned level )
+	{
+		indent( level );
+		value( v, level );
+	}
+
+	void element( const Value::Object::value_type &v, unsigned level )
+	{
+		indent( level );
+		key( v.first );
+		value( v.second, level );
+	}
+
+	// Children are split into contiguous ranges, which are serialized into per-thread buffers
+	// and concatenated in order. Nested containers are serialized serially within a thread.
+	// Exceptions of workers, or of starting them, are rethrown once all started workers are joined.
+	template <class Container>
+	void parallel( const Container &c, unsigned level )
+	{
+		unsigned threads = f_.threads ? f_.threads : std::thread::hardware_concurrency();
+		threads = std::max( 1u, std::min( threads, (unsigned)c.size() ) );
+		std::vector<typename Container::const_iterator> bounds;
+		auto it = c.begin();
+		for( unsigned t = 0; t < threads; t++ )
+		{
+			bounds.push_back( it );
+			std::advance( it, c.size() / threads + ( t < c.size() % threads ? 1 : 0 ) );
+		}
+		bounds.push_back( c.end() );
+
+		std::vector<std::string> chunks( threads );
+		std::vector<std::exception_ptr> errors( threads );
+		std::vector<std::thread> workers;
+		workers.reserve( threads );
+		std::exception_ptr failed;
+		for( unsigned t = 0; t < threads && !failed; t++ )
+		{
+			try
+			{
+				workers.emplace_back( [&, t]() {
+					try
+					{
+						JsonCounter counter;
+						JsonSerializer<JsonCounter>( counter, f_ ).range( bounds[t], bounds[t + 1], c.end(), level );
+						chunks[t].reserve( counter.size() );
+						JsonStringOutput out( chunks[t] );
+						JsonSerializer<JsonStringOutput>( out, f_ ).range( bounds[t], bounds[t + 1], c.end(), level );
+					}
+					catch( ... )
+					{
+						errors[t] = std::current_exception();
+					}
+				} );
+			}
+			catch( ... )
+			{
+				failed = std::current_exception();
+			}
+		}
+		for( auto &w : workers )
+		{
+			w.join();
+		}
+		for( auto &error : errors )
+		{
+			if ( !failed )
+			{
+				failed = error;
+			}
+		}
+		if ( failed )
+		{
+			std::rethrow_exception( failed );
+		}
+
+		// Chunks are followed by closing indentation and bracket, which end the document if container is the root
+		size_t size = ( level - 1 ) * f_.indent_size + 1;
+		for( auto &chunk : chunks )
+		{
+			size += chunk.size();
+		}
+		out_.reserve( size );
+		for( auto &chunk : chunks )
+		{
+			out_.put( chunk.data(), chunk.size() );
+		}
+	}
+};
+
 class JsonImpl
 {
 	enum class State
@@ -207,6 +685,7 @@ class JsonImpl
 		Array
 	};
 
+public:
 	static bool is_lexeme( const std::string &token )
 	{
 		return token == "true" || token == "false" || token == "null";
@@ -307,28 +786,6 @@ class JsonImpl
 		return v;
 	}
 
-public:
-	static std::string escape_string( const std::string &s )
-	{
-		std::string res( s );
-		auto replace_all = []( std::string &s, const char *from, const char *to ) {
-			size_t start = 0;
-			while( ( start = s.find( from, start ) ) != std::string::npos )
-			{
-					 s.replace( start, strlen( from ), to );
-					 start += strlen( to );
-			}
-		};
-		replace_all( res, "\\", "\\\\" );
-		replace_all( res, "\"", "\\\"" );
-		replace_all( res, "\b", "\\b" );
-		replace_all( res, "\f", "\\f" );
-		replace_all( res, "\n", "\\n" );
-		replace_all( res, "\r", "\\r" );
-		replace_all( res, "\t", "\\t" );
-		return res;
-	}
-
 	static std::string unescape_string( const std::string &s )
 	{
 		std::string res( s );
@@ -356,16 +813,23 @@ public:
 		return e.empty();
 	}
 
-	static Value parse( const std::string &json, Error &e )
+	static Value parse( const std::string &json, Error &e, KeyPool *pool = nullptr, MemoryResource *resource = default_resource() )
 	{
 		Value v;
-		parse( json, &v, e );
+		parse( json, &v, e, pool, resource );
 		return v;
 	}
 
-	static void parse( const std::string &json, Value *v, Error &e )
+	// Adds object member, existing member is kept for duplicate keys
+	static Value& member( Value *object, const Key &key, Value &&v )
+	{
+		return object->object_ref().emplace( key, std::move( v ) ).first->second;
+	}
+
+	static void parse( const std::string &json, Value *v, Error &e, KeyPool *pool = nullptr, MemoryResource *resource = default_resource() )
 	{
 		std::string key;
+		Key name;
 		std::stack<Levels> levels;
 		std::stack<Value*> values;
 
@@ -399,18 +863,18 @@ public:
 					if ( levels.empty() )
 					{
 						state = State::End;
-						if ( v ) { *v = build_string( token ); }
+						if ( v ) { *v = Value( build_string( token ), resource ); }
 					}
 					else
 					{
 						state = State::ValueSeparator;
 						if ( levels.top() == Levels::Object )
 						{
-							if ( v ) { values.top()->insert( key, Value( build_string( token ) ) ); }
+							if ( v ) { member( values.top(), name, Value( build_string( token ), resource ) ); }
 						}
 						else if ( v )
 						{
-							values.top()->insert( Value( build_string( token ) ) );
+							values.top()->insert( Value( build_string( token ), resource ) );
 						}
 					}
 					continue;
@@ -427,7 +891,7 @@ public:
 						state = State::ValueSeparator;
 						if ( levels.top() == Levels::Object )
 						{
-							if ( v ) { values.top()->insert( key, build_lexeme( token ) ); }
+							if ( v ) { member( values.top(), name, build_lexeme( token ) ); }
 						}
 						else if ( v )
 						{
@@ -448,7 +912,7 @@ public:
 						state = State::ValueSeparator;
 						if ( levels.top() == Levels::Object )
 						{
-							if ( v ) { values.top()->insert( key, build_number( token, e ) ); }
+							if ( v ) { member( values.top(), name, build_number( token, e ) ); }
 						}
 						else if ( v )
 						{
@@ -471,19 +935,18 @@ public:
 					{
 						if ( v )
 						{
-							*v = Value( Value::Type::Object );
+							*v = Value( Value::Type::Object, resource );
 							values.push( v );
 						}
 					}
 					else if ( levels.top() == Levels::Array && v )
 					{
-						values.top()->insert( Value( Value::Type::Object ) );
-						values.push( &values.top()->back() );
+						values.top()->insert( Value( Value::Type::Object, resource ) );
+						values.push( &values.top()->array_ref().back() );
 					}
 					else if ( v )
 					{
-						values.top()->insert( key, Value( Value::Type::Object ) );
-						values.push( &values.top()->at( key ) );
+						values.push( &member( values.top(), name, Value( Value::Type::Object, resource ) ) );
 					}
 					levels.push( Levels::Object );
 					continue;
@@ -494,19 +957,18 @@ public:
 					{
 						if ( v )
 						{
-							*v = Value( Value::Type::Array );
+							*v = Value( Value::Type::Array, resource );
 							values.push( v );
 						}
 					}
 					else if ( levels.top() == Levels::Array && v )
 					{
-						values.top()->insert( Value( Value::Type::Object ) );
-						values.push( &values.top()->back() );
+						values.top()->insert( Value( Value::Type::Array, resource ) );
+						values.push( &values.top()->array_ref().back() );
 					}
 					else if ( v )
 					{
-						values.top()->insert( key, Value( Value::Type::Array ) );
-						values.push( &values.top()->at( key ) );
+						values.push( &member( values.top(), name, Value( Value::Type::Array, resource ) ) );
 					}
 					levels.push( Levels::Array );
 					continue;
@@ -530,6 +992,7 @@ public:
 						if ( v ) { *v = Value(); }
 						return;
 					}
+					if ( v ) { name = pool ? pool->intern( key ) : Key( key ); }
 					state = State::KeyValueSeparator;
 					continue;
 				}
@@ -587,97 +1050,37 @@ public:
 		}
 	}
 
+	static size_t measure( const Value &value, const Json::Format &f )
+	{
+		JsonCounter counter;
+		JsonSerializer<JsonCounter>( counter, f ).value( value, 0 );
+		return counter.size();
+	}
+
 	static std::string build( const Value &value, Error &e, const Json::Format &f )
 	{
-		std::function<std::string(const Value&, const Json::Format&, unsigned)> build_value =
-			[&]( const Value &value, const Json::Format &f, unsigned level ) -> std::string {
-			std::string s;
-			switch( value.type() )
-			{
-			case Value::Type::Array:
-			{
-				auto &arr = value.get_array();
-				auto size = arr.size();
-				s += '[';
-				if ( f.indent_size )
-				{
-					s += '\n';
-					level++;
-				}
-				for( unsigned i = 0; i < size; i++ )
-				{
-					s += f.indent( level );
-					s += build_value( arr[i], f, level );
-					if ( size > 1 && i <= size - 2 )
-					{
-						s += ',';
-					}
-					if ( f.indent_size )
-					{
-						s += '\n';
-					}
-				}
-				if ( f.indent_size )
-				{
-					level--;
-					s += f.indent( level );
-				}
-				s += ']';
-				return s;
-			}
-			case Value::Type::Object:
-			{
-				auto &obj = value.get_object();
-				auto size = obj.size();
-				s += '{';
-				if ( f.indent_size )
-				{
-					s += '\n';
-					level++;
-				}
-				unsigned i = 0;
-				for( auto &v : obj )
-				{
-					s += f.indent( level );
-					s += '\"';
-					s += v.first;
-					s += '\"';
-					s += ':';
-					if ( f.indent_size )
-					{
-						s += ' ';
-					}
-					s += build_value( v.second, f, level );
-					if ( size > 1 && i <= size - 2 )
-					{
-						s += ',';
-					}
-					if ( f.indent_size )
-					{
-						s += '\n';
-					}
-					i++;
-				}
-				if ( f.indent_size )
-				{
-					level--;
-					s += f.indent( level );
-				}
-				s += '}';
-				return s;
-			}
-			default:
-				if ( value.type() == Value::Type::String )
-				{
-					s += '\"';
-					s += escape_string( value.as_string() );
-					s += '\"';
-					return s;
-				}
-				return value.as_string();
-			}
-		};
-		return build_value( value, f, 0 );
+		std::string s;
+		if ( f.threads != 1 )
+		{
+			// Measuring would be a serial pass over the whole tree, so string is sized from parallel chunks
+			JsonStringOutput out( s );
+			JsonSerializer<JsonStringOutput>( out, f, true ).value( value, 0 );
+			return s;
+		}
+		JsonCounter counter;
+		JsonSerializer<JsonCounter>( counter, f ).value( value, 0 );
+		s.reserve( counter.size() );
+		JsonStringOutput out( s );
+		JsonSerializer<JsonStringOutput>( out, f ).value( value, 0 );
+		return s;
+	}
+
+	static void build( const Value &value, Error &e, const Json::Format &f, Json::Segments &segments )
+	{
+		segments.buffer.clear();
+		JsonSegmentOutput out( segments );
+		JsonSerializer<JsonSegmentOutput>( out, f ).value( value, 0 );
+		out.finish();
 	}
 
 	static std::string format( const std::string &json, Error &e, const Json::Format &formatter )
@@ -712,18 +1115,48 @@ Value Json::parse( const std::string &json, Error &e )
 	return JsonImpl::parse( json, e );
 }
 
-
-std::string Json::build( const Value &value, Error &e )
+Value Json::parse( const std::string &json, Error &e, KeyPool &pool )
 {
-	return JsonImpl::build( value, e, Json::Format() );
+	return JsonImpl::parse( json, e, &pool );
 }
 
-std::string Json::build( const Value &value, Error &e, const Json::Format &formatter )
+Value Json::parse( const std::string &json, Error &e, MemoryResource &resource, KeyPool *pool )
 {
-	return JsonImpl::build( value, e, formatter );
+	return JsonImpl::parse( json, e, pool, &resource );
 }
 
-std::string Json::format( const std::string &json, Error &e, const Format &formatter )
+
+size_t Json::measure( const Value &value, const Format &formatter )
+{
+	return JsonImpl::measure( value, formatter );
+}
+
+std::string Json::build( const Value &value, Error &e )
+{
+	return JsonImpl::build( value, e, Json::Format() );
+}
+
+std::string Json::build( const Value &value, Error &e, const Json::Format &formatter )
+{
+	return JsonImpl::build( value, e, formatter );
+}
+
+void Json::build( const Value &value, Error &e, const Json::Format &formatter, Json::Segments &segments )
+{
+	JsonImpl::build( value, e, formatter, segments );
+}
+
+size_t Json::Segments::size() const
+{
+	size_t size = 0;
+	for( auto &i : iov )
+	{
+		size += i.iov_len;
+	}
+	return size;
+}
+
+std::string Json::format( const std::string &json, Error &e, const Format &formatter )
 {
 	return JsonImpl::format( json, e, formatter );
 }
@@ -733,4 +1166,900 @@ std::string Json::minimize( const std::string &json, Error &e)
 	return JsonImpl::format( json, e, Format() );
 }
 
+
+class JsonWriter::Impl
+{
+public:
+	enum class Level
+	{
+		Object,
+		Array
+	};
+
+	Impl( std::string &buffer, const Json::Format &f ) :
+		f_( f ),
+		out_( &buffer )
+	{
+		levels_.reserve( 32 );
+	}
+
+	Impl( Sink sink, const Json::Format &f ) :
+		f_( f ),
+		sink_( std::move( sink ) ),
+		out_( &buffer_ )
+	{
+		levels_.reserve( 32 );
+	}
+
+	~Impl()
+	{
+		flush();
+	}
+
+	void begin( Level level )
+	{
+		if ( element() )
+		{
+			*out_ += level == Level::Object ? '{' : '[';
+			levels_.push_back( level );
+			first_ = true;
+			state_ = level == Level::Object ? State::Key : State::Value;
+		}
+	}
+
+	void end( Level level )
+	{
+		if ( !e_.empty() )
+		{
+			return;
+		}
+		if ( levels_.empty() || levels_.back() != level || state_ == State::KeyValue )
+		{
+			fail();
+			return;
+		}
+		levels_.pop_back();
+		if ( f_.indent_size )
+		{
+			*out_ += '\n';
+			out_->append( levels_.size() * f_.indent_size, f_.indent_char );
+		}
+		*out_ += level == Level::Object ? '}' : ']';
+		done();
+	}
+
+	void key( const std::string &k )
+	{
+		if ( !e_.empty() )
+		{
+			return;
+		}
+		if ( state_ != State::Key )
+		{
+			fail();
+			return;
+		}
+		separate();
+		JsonStringOutput out( *out_ );
+		json_escape( out, k );
+		*out_ += ':';
+		if ( f_.indent_size )
+		{
+			*out_ += ' ';
+		}
+		state_ = State::KeyValue;
+	}
+
+	void value( const Value &v )
+	{
+		if ( element() )
+		{
+			JsonStringOutput out( *out_ );
+			JsonSerializer<JsonStringOutput>( out, f_ ).value( v, levels_.size() );
+			done();
+		}
+	}
+
+	void raw( const char *s, size_t n )
+	{
+		if ( element() )
+		{
+			out_->append( s, n );
+			done();
+		}
+	}
+
+	void string( const std::string &s )
+	{
+		if ( element() )
+		{
+			JsonStringOutput out( *out_ );
+			json_escape( out, s );
+			done();
+		}
+	}
+
+	void flush()
+	{
+		if ( sink_ && !buffer_.empty() )
+		{
+			sink_( buffer_.data(), buffer_.size() );
+			buffer_.clear();
+		}
+	}
+
+	bool complete() const
+	{
+		return e_.empty() && state_ == State::End;
+	}
+
+	const Error& error() const
+	{
+		return e_;
+	}
+
+private:
+	enum class State
+	{
+		Value,
+		Key,
+		KeyValue,
+		End
+	};
+
+	static constexpr size_t flush_size_ = 4096;
+	Json::Format f_;
+	Sink sink_;
+	std::string buffer_;
+	std::string *out_;
+	std::vector<Level> levels_;
+	State state_ = State::Value;
+	bool first_ = true;
+	Error e_;
+
+	void fail()
+	{
+		e_ = Error( Error::UnexpectedToken, "Unexpected token (level %u)", (unsigned)levels_.size() );
+	}
+
+	// Writes separator and indentation before array element or object key
+	void separate()
+	{
+		if ( levels_.empty() )
+		{
+			return;
+		}
+		if ( !first_ )
+		{
+			*out_ += ',';
+		}
+		first_ = false;
+		if ( f_.indent_size )
+		{
+			*out_ += '\n';
+			out_->append( levels_.size() * f_.indent_size, f_.indent_char );
+		}
+	}
+
+	// Checks if an element may start at current position
+	bool element()
+	{
+		if ( !e_.empty() )
+		{
+			return false;
+		}
+		if ( state_ == State::Value )
+		{
+			separate();
+			return true;
+		}
+		if ( state_ == State::KeyValue )
+		{
+			return true;
+		}
+		fail();
+		return false;
+	}
+
+	void done()
+	{
+		if ( levels_.empty() )
+		{
+			state_ = State::End;
+		}
+		else
+		{
+			first_ = false;
+			state_ = levels_.back() == Level::Object ? State::Key : State::Value;
+		}
+		if ( sink_ && buffer_.size() >= flush_size_ )
+		{
+			flush();
+		}
+	}
+};
+
+JsonWriter::JsonWriter( std::string &buffer, const Json::Format &formatter ) :
+	impl_( new Impl( buffer, formatter ) )
+{}
+
+JsonWriter::JsonWriter( Sink sink, const Json::Format &formatter ) :
+	impl_( new Impl( std::move( sink ), formatter ) )
+{}
+
+JsonWriter::~JsonWriter()
+{}
+
+JsonWriter& JsonWriter::begin_object()
+{
+	impl_->begin( Impl::Level::Object );
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_object()
+{
+	impl_->end( Impl::Level::Object );
+	return *this;
+}
+
+JsonWriter& JsonWriter::begin_array()
+{
+	impl_->begin( Impl::Level::Array );
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_array()
+{
+	impl_->end( Impl::Level::Array );
+	return *this;
+}
+
+JsonWriter& JsonWriter::key( const std::string &k )
+{
+	impl_->key( k );
+	return *this;
+}
+
+JsonWriter& JsonWriter::key( const char *k )
+{
+	impl_->key( k );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value()
+{
+	impl_->raw( "null", 4 );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( bool v )
+{
+	if ( v )
+	{
+		impl_->raw( "true", 4 );
+	}
+	else
+	{
+		impl_->raw( "false", 5 );
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( int32_t v )
+{
+	return value( (int64_t)v );
+}
+
+JsonWriter& JsonWriter::value( uint32_t v )
+{
+	return value( (int64_t)v );
+}
+
+JsonWriter& JsonWriter::value( int64_t v )
+{
+	char buf[21];
+	int len = snprintf( buf, sizeof( buf ), "%" PRId64, v );
+	impl_->raw( buf, len );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( uint64_t v )
+{
+	char buf[21];
+	int len = snprintf( buf, sizeof( buf ), "%" PRIu64, v );
+	impl_->raw( buf, len );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( float v )
+{
+	return value( (double)v );
+}
+
+JsonWriter& JsonWriter::value( double v )
+{
+	char buf[50];
+	int len = snprintf( buf, sizeof( buf ), "%g", v );
+	impl_->raw( buf, len );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( const std::string &v )
+{
+	impl_->string( v );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( const char *v )
+{
+	impl_->string( v );
+	return *this;
+}
+
+JsonWriter& JsonWriter::value( const Value &v )
+{
+	impl_->value( v );
+	return *this;
+}
+
+void JsonWriter::flush()
+{
+	impl_->flush();
+}
+
+bool JsonWriter::complete() const
+{
+	return impl_->complete();
+}
+
+const Error& JsonWriter::error() const
+{
+	return impl_->error();
+}
+
+
+class JsonReader::Impl
+{
+public:
+	Impl( const std::string &json ) :
+		tokenizer_( json )
+	{
+		first_.reserve( 32 );
+	}
+
+	bool begin( const char *open )
+	{
+		if ( !expect( open ) )
+		{
+			return false;
+		}
+		first_.push_back( true );
+		return true;
+	}
+
+	bool next( const char *close )
+	{
+		if ( !e_.empty() || first_.empty() )
+		{
+			return false;
+		}
+		if ( peek() == close )
+		{
+			consume();
+			first_.pop_back();
+			return false;
+		}
+		if ( !first_.back() && !expect( "," ) )
+		{
+			return false;
+		}
+		first_.back() = false;
+		return true;
+	}
+
+	bool next_key( std::string &key )
+	{
+		if ( !next( "}" ) )
+		{
+			return false;
+		}
+		if ( !JsonImpl::is_string( peek() ) )
+		{
+			fail( Error::UnexpectedToken );
+			return false;
+		}
+		key = JsonImpl::build_string( token_ );
+		consume();
+		return expect( ":" );
+	}
+
+	bool read( bool &v )
+	{
+		if ( peek() == "true" || token_ == "false" )
+		{
+			v = token_ == "true";
+			consume();
+			return true;
+		}
+		return type_mismatch();
+	}
+
+	bool read( Value::Int &v )
+	{
+		if ( JsonImpl::is_number( peek() ) && token_.find_first_of( ".eE" ) == std::string::npos )
+		{
+			errno = 0;
+			v = strtoll( token_.c_str(), nullptr, 10 );
+			if ( errno != 0 )
+			{
+				fail( Error::OutOfRange );
+				return false;
+			}
+			consume();
+			return true;
+		}
+		return type_mismatch();
+	}
+
+	bool read( uint64_t &v )
+	{
+		if ( JsonImpl::is_number( peek() ) && token_.find_first_of( ".eE" ) == std::string::npos )
+		{
+			errno = 0;
+			v = strtoull( token_.c_str(), nullptr, 10 );
+			// strtoull() negates instead of rejecting minus sign
+			if ( errno != 0 || ( token_[0] == '-' && v != 0 ) )
+			{
+				fail( Error::OutOfRange );
+				return false;
+			}
+			consume();
+			return true;
+		}
+		return type_mismatch();
+	}
+
+	bool read( Value::Float &v )
+	{
+		if ( JsonImpl::is_number( peek() ) )
+		{
+			v = strtod( token_.c_str(), nullptr );
+			consume();
+			return true;
+		}
+		return type_mismatch();
+	}
+
+	bool read( std::string &v )
+	{
+		if ( JsonImpl::is_string( peek() ) )
+		{
+			v = JsonImpl::build_string( token_ );
+			consume();
+			return true;
+		}
+		return type_mismatch();
+	}
+
+	// Open containers are kept on a stack rather than in recursive calls,
+	// so nesting depth of input is not limited by the call stack
+	bool read( Value &v )
+	{
+		std::vector<Level> levels;
+		for( ;; )
+		{
+			Value item;
+			peek();
+			if ( token_ == "{" || token_ == "[" )
+			{
+				bool object = token_ == "{";
+				begin( object ? "{" : "[" );
+				levels.push_back( Level{ Value( object ? Value::Type::Object : Value::Type::Array ), std::string() } );
+			}
+			else if ( !read_scalar( item ) )
+			{
+				return false;
+			}
+			else if ( levels.empty() )
+			{
+				v = std::move( item );
+				return true;
+			}
+			else
+			{
+				add( levels.back(), std::move( item ) );
+			}
+
+			// Closes finished containers, until one of them has more elements
+			while( !( levels.back().value.is_object() ? next_key( levels.back().key ) : next( "]" ) ) )
+			{
+				if ( !e_.empty() )
+				{
+					return false;
+				}
+				item = std::move( levels.back().value );
+				levels.pop_back();
+				if ( levels.empty() )
+				{
+					v = std::move( item );
+					return true;
+				}
+				add( levels.back(), std::move( item ) );
+			}
+		}
+	}
+
+	bool skip()
+	{
+		std::vector<bool> objects; // Open containers, true for objects
+		std::string key;
+		do
+		{
+			peek();
+			if ( token_ == "{" || token_ == "[" )
+			{
+				objects.push_back( token_ == "{" );
+				begin( objects.back() ? "{" : "[" );
+			}
+			else if ( JsonImpl::is_string( token_ ) || JsonImpl::is_lexeme( token_ ) || JsonImpl::is_number( token_ ) )
+			{
+				consume();
+			}
+			else
+			{
+				fail( Error::UnexpectedToken );
+				return false;
+			}
+
+			while( !objects.empty() && !( objects.back() ? next_key( key ) : next( "]" ) ) )
+			{
+				if ( !e_.empty() )
+				{
+					return false;
+				}
+				objects.pop_back();
+			}
+		}
+		while( !objects.empty() );
+		return e_.empty();
+	}
+
+	bool finish()
+	{
+		if ( e_.empty() && ( !first_.empty() || !peek().empty() ) )
+		{
+			fail( Error::UnexpectedEnding );
+		}
+		return e_.empty();
+	}
+
+	void fail( Error::ErrorCodes code )
+	{
+		if ( e_.empty() )
+		{
+			auto pos = tokenizer_.get_last_token_position();
+			switch( code )
+			{
+			case Error::UnexpectedType:
+				e_ = Error( code, "Unexpected type (%d:%d)", pos.first, pos.second );
+				break;
+			case Error::UnexpectedEnding:
+				e_ = Error( code, "Unexpected ending (%d:%d)", pos.first, pos.second );
+				break;
+			case Error::OutOfRange:
+				e_ = Error( code, "Out of range (%d:%d)", pos.first, pos.second );
+				break;
+			case Error::BadValue:
+				e_ = Error( code, "Bad value (%d:%d)", pos.first, pos.second );
+				break;
+			default:
+				e_ = Error( code, "Unexpected token (%d:%d)", pos.first, pos.second );
+				break;
+			}
+		}
+	}
+
+	const Error& error() const
+	{
+		return e_;
+	}
+
+private:
+	// Container being read, and key of its next member
+	struct Level
+	{
+		Value value;
+		std::string key;
+	};
+
+	JsonTokenizer tokenizer_;
+	std::string token_;
+	bool has_token_ = false;
+	std::vector<bool> first_;
+	Error e_;
+
+	const std::string& peek()
+	{
+		if ( !has_token_ )
+		{
+			Error e;
+			token_ = tokenizer_.get_token( e );
+			if ( !e.empty() && e_.empty() )
+			{
+				e_ = e;
+			}
+			has_token_ = true;
+		}
+		return token_;
+	}
+
+	void consume()
+	{
+		has_token_ = false;
+	}
+
+	bool expect( const char *token )
+	{
+		if ( !e_.empty() )
+		{
+			return false;
+		}
+		if ( peek() != token )
+		{
+			fail( peek().empty() ? Error::UnexpectedEnding : Error::UnexpectedToken );
+			return false;
+		}
+		consume();
+		return true;
+	}
+
+	bool read_scalar( Value &v )
+	{
+		if ( JsonImpl::is_string( token_ ) )
+		{
+			v = JsonImpl::build_string( token_ );
+		}
+		else if ( JsonImpl::is_lexeme( token_ ) )
+		{
+			v = JsonImpl::build_lexeme( token_ );
+		}
+		else if ( JsonImpl::is_number( token_ ) )
+		{
+			Error e;
+			v = JsonImpl::build_number( token_, e );
+			if ( !e.empty() )
+			{
+				fail( Error::BadValue );
+				return false;
+			}
+		}
+		else
+		{
+			fail( Error::UnexpectedToken );
+			return false;
+		}
+		consume();
+		return e_.empty();
+	}
+
+	static void add( Level &level, Value &&item )
+	{
+		if ( level.value.is_object() )
+		{
+			level.value.insert( level.key, std::move( item ) );
+		}
+		else
+		{
+			level.value.insert( std::move( item ) );
+		}
+	}
+
+	bool type_mismatch()
+	{
+		fail( token_.empty() ? Error::UnexpectedEnding : Error::UnexpectedType );
+		return false;
+	}
+};
+
+JsonReader::JsonReader( const std::string &json ) :
+	impl_( new Impl( json ) )
+{}
+
+JsonReader::~JsonReader()
+{}
+
+bool JsonReader::begin_object()
+{
+	return impl_->begin( "{" );
+}
+
+bool JsonReader::next_key( std::string &key )
+{
+	return impl_->next_key( key );
+}
+
+bool JsonReader::begin_array()
+{
+	return impl_->begin( "[" );
+}
+
+bool JsonReader::next_element()
+{
+	return impl_->next( "]" );
+}
+
+bool JsonReader::read( bool &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::read( Value::Int &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::read( uint64_t &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::read( Value::Float &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::read( std::string &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::read( Value &v )
+{
+	return impl_->read( v );
+}
+
+bool JsonReader::skip()
+{
+	return impl_->skip();
+}
+
+bool JsonReader::finish()
+{
+	return impl_->finish();
+}
+
+void JsonReader::fail( Error::ErrorCodes code )
+{
+	impl_->fail( code );
+}
+
+const Error& JsonReader::error() const
+{
+	return impl_->error();
+}
+
+namespace
+{
+
+// Parsed literal, never modified after it is published
+struct ParsedLiteral
+{
+	const char *text;
+	Value value;
+	Error e;
+};
+
+// Open addressing table of parsed literals, keyed by literal address. Lookups don't lock,
+// inserts are serialized and publish entries with release stores. When table gets half full,
+// it is replaced by a larger copy. Replaced tables are kept, since readers may still probe them.
+class LiteralCache
+{
+public:
+	LiteralCache() :
+		table_( nullptr )
+	{}
+
+	const ParsedLiteral* find( const char *text ) const
+	{
+		return find( table_.load( std::memory_order_acquire ), text );
+	}
+
+	const ParsedLiteral* insert( const char *text, size_t size )
+	{
+		std::lock_guard<std::mutex> guard( lock_ );
+		auto table = table_.load( std::memory_order_relaxed );
+		if ( auto parsed = find( table, text ) )
+		{
+			return parsed;
+		}
+		std::unique_ptr<ParsedLiteral> parsed( new ParsedLiteral{ text, Value(), Error() } );
+		parsed->value = Json::parse( std::string( text, size ), parsed->e );
+		if ( !table || 2 * ( literals_.size() + 1 ) > table->size )
+		{
+			std::unique_ptr<Table> larger( new Table( table ? 2 * table->size : 64 ) );
+			for( auto &literal : literals_ )
+			{
+				place( larger.get(), literal.get() );
+			}
+			tables_.push_back( std::move( larger ) );
+			table = tables_.back().get();
+		}
+		place( table, parsed.get() );
+		table_.store( table, std::memory_order_release );
+		literals_.push_back( std::move( parsed ) );
+		return literals_.back().get();
+	}
+
+private:
+	struct Table
+	{
+		size_t size;  // Power of two
+		std::unique_ptr<std::atomic<const ParsedLiteral*>[]> slots;
+
+		Table( size_t size ) :
+			size( size ),
+			slots( new std::atomic<const ParsedLiteral*>[size]() )
+		{}
+	};
+
+	std::atomic<Table*> table_;
+	std::mutex lock_;
+	std::vector<std::unique_ptr<Table> > tables_;
+	std::vector<std::unique_ptr<ParsedLiteral> > literals_;
+
+	static size_t slot( const Table *table, const char *text )
+	{
+		return (size_t)( ( (uintptr_t)text * UINT64_C( 0x9e3779b97f4a7c15 ) ) >> 16 ) & ( table->size - 1 );
+	}
+
+	static const ParsedLiteral* find( const Table *table, const char *text )
+	{
+		if ( !table )
+		{
+			return nullptr;
+		}
+		for( size_t i = slot( table, text ); ; i = ( i + 1 ) & ( table->size - 1 ) )
+		{
+			auto parsed = table->slots[i].load( std::memory_order_acquire );
+			if ( !parsed || parsed->text == text )
+			{
+				return parsed;
+			}
+		}
+	}
+
+	static void place( Table *table, const ParsedLiteral *parsed )
+	{
+		size_t i = slot( table, parsed->text );
+		while( table->slots[i].load( std::memory_order_relaxed ) )
+		{
+			i = ( i + 1 ) & ( table->size - 1 );
+		}
+		table->slots[i].store( parsed, std::memory_order_release );
+	}
+};
+
+} // namespace
+
+const Value& JsonLiteral::value( Error &e ) const
+{
+	static LiteralCache cache;
+	auto parsed = cache.find( text_ );
+	if ( !parsed )
+	{
+		parsed = cache.insert( text_, size_ );
+	}
+	if ( !parsed->e.empty() )
+	{
+		e = parsed->e;
+	}
+	return parsed->value;
+}
+
+const Value& JsonLiteral::value() const
+{
+	Error e;
+	return value( e );
+}
+
 } // namespace jsoncpp
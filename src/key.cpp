@@ -0,0 +1,62 @@
+#include "key.hpp"
+
+namespace jsoncpp
+{
+
+const std::string& Key::blank()
+{
+	static const std::string s;
+	return s;
+}
+
+const std::string& Key::encode( std::string &&s ) const
+{
+	if ( !interned() )
+	{
+		return s;
+	}
+	std::string *expected = nullptr;
+	std::string *stored = new std::string( std::move( s ) );
+	if ( !rep_->encoded.compare_exchange_strong( expected, stored, std::memory_order_acq_rel ) )
+	{
+		delete stored;
+		return *expected;
+	}
+	return *stored;
+}
+
+Key KeyPool::intern( const char *s, size_t n )
+{
+	auto h = Key::hash( s, n );
+	std::lock_guard<std::mutex> lock( mutex_ );
+	auto range = keys_.equal_range( h );
+	for( auto i = range.first; i != range.second; ++i )
+	{
+		if ( i->second.equals( s, n ) )
+		{
+			return i->second;
+		}
+	}
+	Key key( s, n );
+	key.rep_->interned = true;
+	return keys_.emplace( h, std::move( key ) )->second;
+}
+
+Key KeyPool::intern( const std::string &s )
+{
+	return intern( s.data(), s.size() );
+}
+
+size_t KeyPool::size() const
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	return keys_.size();
+}
+
+void KeyPool::clear()
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	keys_.clear();
+}
+
+} // namespace jsoncpp
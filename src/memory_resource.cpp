@@ -0,0 +1,84 @@
+#include "memory_resource.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+namespace jsoncpp
+{
+
+class NewDeleteResource : public MemoryResource
+{
+protected:
+	void* do_allocate( size_t bytes, size_t ) override
+	{
+		return ::operator new( bytes );
+	}
+
+	void do_deallocate( void *p, size_t, size_t ) override
+	{
+		::operator delete( p );
+	}
+};
+
+static NewDeleteResource new_delete_resource;
+static std::atomic<MemoryResource*> default_resource_( &new_delete_resource );
+
+MemoryResource* default_resource() noexcept
+{
+	return default_resource_.load( std::memory_order_acquire );
+}
+
+MemoryResource* set_default_resource( MemoryResource *resource ) noexcept
+{
+	return default_resource_.exchange( resource ? resource : &new_delete_resource, std::memory_order_acq_rel );
+}
+
+MonotonicResource::MonotonicResource( size_t block_size, MemoryResource *upstream ) :
+	upstream_( upstream ),
+	block_size_( block_size ? block_size : 4096 ),
+	current_( nullptr ),
+	left_( 0 )
+{
+}
+
+MonotonicResource::~MonotonicResource()
+{
+	release();
+}
+
+void MonotonicResource::release()
+{
+	for( auto &b : blocks_ )
+	{
+		upstream_->deallocate( b.data, b.size );
+	}
+	blocks_.clear();
+	current_ = nullptr;
+	left_ = 0;
+}
+
+void* MonotonicResource::do_allocate( size_t bytes, size_t alignment )
+{
+	size_t padding = (size_t)( -(uintptr_t)current_ & ( alignment - 1 ) );
+	if ( !current_ || padding + bytes > left_ )
+	{
+		// Blocks come from upstream with max alignment, oversized requests get their own block
+		size_t size = std::max( block_size_, bytes + alignment );
+		blocks_.reserve( blocks_.size() + 1 );
+		blocks_.push_back( Block{ upstream_->allocate( size ), size } );
+		current_ = static_cast<char*>( blocks_.back().data );
+		left_ = size;
+		padding = (size_t)( -(uintptr_t)current_ & ( alignment - 1 ) );
+	}
+	void *p = current_ + padding;
+	current_ += padding + bytes;
+	left_ -= padding + bytes;
+	return p;
+}
+
+void MonotonicResource::do_deallocate( void*, size_t, size_t )
+{
+}
+
+} // namespace jsoncpp
@@ -0,0 +1,964 @@
+
+#include <algorithm>
+#include <cstring>
+#include "path.hpp"
+#include "utf8.hpp"
+
+namespace jsoncpp
+{
+
+class JsonPath::Impl
+{
+public:
+	struct Selector
+	{
+		enum class Kind { Name, Wildcard, Index, Slice, Filter };
+
+		Kind kind;
+		Key name;
+		int64_t start;  // Index for Kind::Index
+		int64_t end;
+		int64_t step;
+		bool has_start;
+		bool has_end;
+		size_t filter;  // Expression node
+	};
+
+	struct Step
+	{
+		bool descendant;
+		std::vector<Selector> selectors;
+	};
+
+	struct Query
+	{
+		bool absolute;
+		std::vector<Step> steps;
+	};
+
+	enum class Op { Or, And, Not, Exists, Eq, Ne, Lt, Le, Gt, Ge, Literal, Query };
+
+	// Filter expression node, operands are indices of other nodes
+	struct Node
+	{
+		Op op;
+		size_t lhs;
+		size_t rhs;
+		Value literal;
+		Query query;
+	};
+
+	Query path_;
+	std::vector<Node> nodes_;
+	bool valid_ = false;
+
+	bool init( const std::string &path, Error &e )
+	{
+		path_.steps.clear();
+		nodes_.clear();
+		valid_ = false;
+		text_ = &path;
+		pos_ = 0;
+		e_ = &e;
+		if ( !expect( '$' ) || !query( path_ ) )
+		{
+			return false;
+		}
+		if ( pos_ != text_->size() )
+		{
+			return fail();
+		}
+		path_.absolute = true;
+		valid_ = true;
+		return true;
+	}
+
+	// Positions of values on the way from root to the visited one, array index or object key
+	typedef std::vector<std::pair<size_t, Value::Object::key_type> > Trail;
+
+	// Walks steps from i on, passing selected values to f, until f returns false.
+	// Values are only read, trail (if any) tracks where the visited value is.
+	template <typename F>
+	bool walk( const std::vector<Step> &steps, size_t i, const Value &v, const Value &root, F &f, Trail *trail = nullptr ) const
+	{
+		if ( i == steps.size() )
+		{
+			return f( v );
+		}
+		const auto &step = steps[i];
+		for( const auto &selector : step.selectors )
+		{
+			if ( !apply( selector, steps, i, v, root, f, trail ) )
+			{
+				return false;
+			}
+		}
+		if ( step.descendant )
+		{
+			if ( v.is_array() )
+			{
+				auto &arr = v.get_array();
+				for( size_t j = 0; j < arr.size(); j++ )
+				{
+					if ( !enter( steps, i, arr[j], j, nullptr, root, f, trail ) )
+					{
+						return false;
+					}
+				}
+			}
+			else if ( v.is_object() )
+			{
+				for( auto &member : v.get_object() )
+				{
+					if ( !enter( steps, i, member.second, 0, &member.first, root, f, trail ) )
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	const Value* first( const Query &query, const Value &current, const Value &root ) const
+	{
+		const Value *found = nullptr;
+		auto f = [&found]( const Value &v ) { found = &v; return false; };
+		walk( query.steps, 0, query.absolute ? root : current, root, f );
+		return found;
+	}
+
+	/**
+	 * Selects mutable values, all of them or the first one, and passes them to f. Document is walked
+	 * through const access, and selected values are then reached by mutable access from root,
+	 * so only payloads on the way to selected values are detached from copies.
+	 */
+	template <typename F>
+	void walk( Value &root, bool all, F &f ) const
+	{
+		Trail trail;
+		Trail trails; // Trails of selected values, one after another
+		std::vector<size_t> ends;
+		auto collect = [&]( const Value& )
+		{
+			trails.insert( trails.end(), trail.begin(), trail.end() );
+			ends.push_back( trails.size() );
+			return all;
+		};
+		walk( path_.steps, 0, root, root, collect, &trail );
+		size_t begin = 0;
+		for( auto end : ends )
+		{
+			Value *v = &root;
+			for( ; begin < end; begin++ )
+			{
+				if ( v->is_array() )
+				{
+					v = &v->get_array()[trails[begin].first];
+				}
+				else
+				{
+					v = &v->get_object().find( trails[begin].second )->second;
+				}
+			}
+			f( *v );
+		}
+	}
+
+private:
+	const std::string *text_ = nullptr;
+	size_t pos_ = 0;
+	Error *e_ = nullptr;
+
+	// Walks into child value, which is element index of array or member key of object
+	template <typename F>
+	bool enter( const std::vector<Step> &steps, size_t i, const Value &child, size_t index,
+				const Value::Object::key_type *key, const Value &root, F &f, Trail *trail ) const
+	{
+		if ( !trail )
+		{
+			return walk( steps, i, child, root, f );
+		}
+		trail->emplace_back( index, key ? *key : Value::Object::key_type() );
+		bool more = walk( steps, i, child, root, f, trail );
+		trail->pop_back();
+		return more;
+	}
+
+	template <typename F>
+	bool apply( const Selector &selector, const std::vector<Step> &steps, size_t i, const Value &v, const Value &root, F &f, Trail *trail ) const
+	{
+		switch( selector.kind )
+		{
+		case Selector::Kind::Name:
+			if ( v.is_object() )
+			{
+				auto &o = v.get_object();
+				auto member = o.find( selector.name );
+				if ( member != o.end() )
+				{
+					return enter( steps, i + 1, member->second, 0, &member->first, root, f, trail );
+				}
+			}
+			break;
+		case Selector::Kind::Wildcard:
+		case Selector::Kind::Filter:
+			if ( v.is_array() )
+			{
+				auto &arr = v.get_array();
+				for( size_t j = 0; j < arr.size(); j++ )
+				{
+					if ( !select( selector, arr[j], root ) )
+					{
+						continue;
+					}
+					if ( !enter( steps, i + 1, arr[j], j, nullptr, root, f, trail ) )
+					{
+						return false;
+					}
+				}
+			}
+			else if ( v.is_object() )
+			{
+				for( auto &member : v.get_object() )
+				{
+					if ( !select( selector, member.second, root ) )
+					{
+						continue;
+					}
+					if ( !enter( steps, i + 1, member.second, 0, &member.first, root, f, trail ) )
+					{
+						return false;
+					}
+				}
+			}
+			break;
+		case Selector::Kind::Index:
+			if ( v.is_array() )
+			{
+				auto &arr = v.get_array();
+				auto n = (int64_t)arr.size();
+				auto index = selector.start < 0 ? selector.start + n : selector.start;
+				if ( index >= 0 && index < n )
+				{
+					return enter( steps, i + 1, arr[(size_t)index], (size_t)index, nullptr, root, f, trail );
+				}
+			}
+			break;
+		case Selector::Kind::Slice:
+			if ( v.is_array() && selector.step != 0 )
+			{
+				auto &arr = v.get_array();
+				auto n = (int64_t)arr.size();
+				auto normalize = [n]( int64_t i ) { return i < 0 ? i + n : i; };
+				auto clamp = []( int64_t i, int64_t lo, int64_t hi ) { return i < lo ? lo : ( i > hi ? hi : i ); };
+				if ( selector.step > 0 )
+				{
+					auto lower = clamp( selector.has_start ? normalize( selector.start ) : 0, 0, n );
+					auto upper = clamp( selector.has_end ? normalize( selector.end ) : n, 0, n );
+					for( auto j = lower; j < upper; j += selector.step )
+					{
+						if ( !enter( steps, i + 1, arr[(size_t)j], (size_t)j, nullptr, root, f, trail ) )
+						{
+							return false;
+						}
+					}
+				}
+				else
+				{
+					auto upper = clamp( selector.has_start ? normalize( selector.start ) : n - 1, -1, n - 1 );
+					auto lower = clamp( selector.has_end ? normalize( selector.end ) : -n - 1, -1, n - 1 );
+					for( auto j = upper; lower < j; j += selector.step )
+					{
+						if ( !enter( steps, i + 1, arr[(size_t)j], (size_t)j, nullptr, root, f, trail ) )
+						{
+							return false;
+						}
+					}
+				}
+			}
+			break;
+		}
+		return true;
+	}
+
+	// Checks whether child value passes wildcard or filter selector
+	bool select( const Selector &selector, const Value &v, const Value &root ) const
+	{
+		return selector.kind == Selector::Kind::Wildcard || test( selector.filter, v, root );
+	}
+
+	bool test( size_t node, const Value &current, const Value &root ) const
+	{
+		const auto &n = nodes_[node];
+		switch( n.op )
+		{
+		case Op::Or:     return test( n.lhs, current, root ) || test( n.rhs, current, root );
+		case Op::And:    return test( n.lhs, current, root ) && test( n.rhs, current, root );
+		case Op::Not:    return !test( n.lhs, current, root );
+		case Op::Exists: return first( nodes_[n.lhs].query, current, root ) != nullptr;
+		case Op::Eq:     return equal( operand( n.lhs, current, root ), operand( n.rhs, current, root ) );
+		case Op::Ne:     return !equal( operand( n.lhs, current, root ), operand( n.rhs, current, root ) );
+		case Op::Lt:     return less( operand( n.lhs, current, root ), operand( n.rhs, current, root ) );
+		case Op::Gt:     return less( operand( n.rhs, current, root ), operand( n.lhs, current, root ) );
+		case Op::Le:
+		{
+			auto l = operand( n.lhs, current, root );
+			auto r = operand( n.rhs, current, root );
+			return less( l, r ) || equal( l, r );
+		}
+		case Op::Ge:
+		{
+			auto l = operand( n.lhs, current, root );
+			auto r = operand( n.rhs, current, root );
+			return less( r, l ) || equal( l, r );
+		}
+		default:
+			return false;
+		}
+	}
+
+	// Returns literal or value selected by singular query, nullptr if query selects nothing
+	const Value* operand( size_t node, const Value &current, const Value &root ) const
+	{
+		const auto &n = nodes_[node];
+		return n.op == Op::Literal ? &n.literal : first( n.query, current, root );
+	}
+
+	static bool numeric( const Value &v )
+	{
+		return v.is_int() || v.is_float();
+	}
+
+	static bool equal( const Value *lhs, const Value *rhs )
+	{
+		if ( !lhs || !rhs )
+		{
+			return !lhs && !rhs;
+		}
+		if ( numeric( *lhs ) && numeric( *rhs ) && lhs->type() != rhs->type() )
+		{
+			return lhs->as_double() == rhs->as_double();
+		}
+		return *lhs == *rhs;
+	}
+
+	static bool less( const Value *lhs, const Value *rhs )
+	{
+		if ( !lhs || !rhs )
+		{
+			return false;
+		}
+		if ( lhs->is_int() && rhs->is_int() )
+		{
+			return lhs->get_int() < rhs->get_int();
+		}
+		if ( numeric( *lhs ) && numeric( *rhs ) )
+		{
+			return lhs->as_double() < rhs->as_double();
+		}
+		if ( lhs->is_string() && rhs->is_string() )
+		{
+			auto l = lhs->string_ref();
+			auto r = rhs->string_ref();
+			auto c = std::memcmp( l.data(), r.data(), std::min( l.size(), r.size() ) );
+			return c < 0 || ( c == 0 && l.size() < r.size() );
+		}
+		return false;
+	}
+
+	//
+	// Parsing
+	//
+
+	bool fail()
+	{
+		if ( pos_ >= text_->size() )
+		{
+			*e_ = Error( Error::UnexpectedEnding, "Unexpected ending (%u)", (unsigned)pos_ );
+		}
+		else
+		{
+			*e_ = Error( Error::UnexpectedCharacter, "Unexpected character (%u)", (unsigned)pos_ );
+		}
+		return false;
+	}
+
+	char peek( size_t offset = 0 ) const
+	{
+		return pos_ + offset < text_->size() ? (*text_)[pos_ + offset] : 0;
+	}
+
+	void skip_spaces()
+	{
+		while( peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r' )
+		{
+			pos_++;
+		}
+	}
+
+	bool expect( char c )
+	{
+		if ( peek() != c )
+		{
+			return fail();
+		}
+		pos_++;
+		return true;
+	}
+
+	static bool name_first( char c )
+	{
+		return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || c == '_' || (unsigned char)c >= 0x80;
+	}
+
+	static bool digit( char c )
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	// Segments following $ or @
+	bool query( Query &q )
+	{
+		while( true )
+		{
+			auto start = pos_;
+			skip_spaces();
+			if ( peek() == '.' && peek( 1 ) == '.' )
+			{
+				pos_ += 2;
+				q.steps.push_back( Step{ true, {} } );
+				if ( peek() == '[' )
+				{
+					if ( !bracket( q.steps.back() ) )
+					{
+						return false;
+					}
+				}
+				else if ( !shorthand( q.steps.back() ) )
+				{
+					return false;
+				}
+			}
+			else if ( peek() == '.' )
+			{
+				pos_++;
+				q.steps.push_back( Step{ false, {} } );
+				if ( !shorthand( q.steps.back() ) )
+				{
+					return false;
+				}
+			}
+			else if ( peek() == '[' )
+			{
+				q.steps.push_back( Step{ false, {} } );
+				if ( !bracket( q.steps.back() ) )
+				{
+					return false;
+				}
+			}
+			else
+			{
+				pos_ = start;
+				return true;
+			}
+		}
+	}
+
+	// Wildcard or member name after . or ..
+	bool shorthand( Step &step )
+	{
+		Selector selector = Selector();
+		if ( peek() == '*' )
+		{
+			pos_++;
+			selector.kind = Selector::Kind::Wildcard;
+		}
+		else if ( name_first( peek() ) )
+		{
+			auto start = pos_;
+			while( name_first( peek() ) || digit( peek() ) )
+			{
+				pos_++;
+			}
+			selector.kind = Selector::Kind::Name;
+			selector.name = Key( text_->data() + start, pos_ - start );
+		}
+		else
+		{
+			return fail();
+		}
+		step.selectors.push_back( std::move( selector ) );
+		return true;
+	}
+
+	bool bracket( Step &step )
+	{
+		pos_++;
+		while( true )
+		{
+			skip_spaces();
+			Selector selector = Selector();
+			if ( !this->selector( selector ) )
+			{
+				return false;
+			}
+			step.selectors.push_back( std::move( selector ) );
+			skip_spaces();
+			if ( peek() != ',' )
+			{
+				return expect( ']' );
+			}
+			pos_++;
+		}
+	}
+
+	bool selector( Selector &selector )
+	{
+		auto c = peek();
+		if ( c == '\'' || c == '"' )
+		{
+			std::string name;
+			if ( !string( name ) )
+			{
+				return false;
+			}
+			selector.kind = Selector::Kind::Name;
+			selector.name = Key( std::move( name ) );
+			return true;
+		}
+		if ( c == '*' )
+		{
+			pos_++;
+			selector.kind = Selector::Kind::Wildcard;
+			return true;
+		}
+		if ( c == '?' )
+		{
+			pos_++;
+			selector.kind = Selector::Kind::Filter;
+			return logical_or( selector.filter );
+		}
+		selector.kind = Selector::Kind::Index;
+		selector.step = 1;
+		if ( c != ':' )
+		{
+			if ( !integer( selector.start ) )
+			{
+				return false;
+			}
+			selector.has_start = true;
+			skip_spaces();
+			if ( peek() != ':' )
+			{
+				return true;
+			}
+		}
+		selector.kind = Selector::Kind::Slice;
+		pos_++;
+		skip_spaces();
+		if ( peek() == '-' || digit( peek() ) )
+		{
+			if ( !integer( selector.end ) )
+			{
+				return false;
+			}
+			selector.has_end = true;
+			skip_spaces();
+		}
+		if ( peek() == ':' )
+		{
+			pos_++;
+			skip_spaces();
+			if ( ( peek() == '-' || digit( peek() ) ) && !integer( selector.step ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Integer without leading zeros, limited to I-JSON range, so slice arithmetic can't overflow
+	bool integer( int64_t &value )
+	{
+		static const Value::Int max = ( Value::Int( 1 ) << 53 ) - 1;
+		auto start = pos_;
+		if ( peek() == '-' )
+		{
+			pos_++;
+		}
+		auto first = pos_;
+		while( digit( peek() ) )
+		{
+			pos_++;
+		}
+		Value::Int i = 0;
+		if ( ( pos_ > first && (*text_)[first] == '0' && ( pos_ - first > 1 || first > start ) ) ||
+			 !Value( text_->substr( start, pos_ - start ) ).try_get( i ) || i > max || i < -max )
+		{
+			pos_ = start;
+			return fail();
+		}
+		value = i;
+		return true;
+	}
+
+	// Quoted string with JSON escapes, either quote character may be used
+	bool string( std::string &s )
+	{
+		auto quote = peek();
+		pos_++;
+		while( peek() != quote )
+		{
+			auto c = peek();
+			if ( c == 0 && pos_ >= text_->size() )
+			{
+				return fail();
+			}
+			pos_++;
+			if ( c != '\\' )
+			{
+				s += c;
+				continue;
+			}
+			c = peek();
+			pos_++;
+			switch( c )
+			{
+			case '\'': s += '\''; break;
+			case '"':  s += '"';  break;
+			case '\\': s += '\\'; break;
+			case '/':  s += '/';  break;
+			case 'b':  s += '\b'; break;
+			case 'f':  s += '\f'; break;
+			case 'n':  s += '\n'; break;
+			case 'r':  s += '\r'; break;
+			case 't':  s += '\t'; break;
+			case 'u':
+			{
+				char32_t code = 0;
+				if ( !hex( code ) )
+				{
+					return false;
+				}
+				if ( code >= 0xD800 && code <= 0xDBFF && peek() == '\\' && peek( 1 ) == 'u' )
+				{
+					pos_ += 2;
+					char32_t low = 0;
+					if ( !hex( low ) )
+					{
+						return false;
+					}
+					code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+				}
+				Error e;
+				s += Utf8::encode( std::u32string( 1, code ), e );
+				if ( !e.empty() )
+				{
+					return fail();
+				}
+				break;
+			}
+			default:
+				pos_--;
+				return fail();
+			}
+		}
+		pos_++;
+		return true;
+	}
+
+	bool hex( char32_t &code )
+	{
+		for( int i = 0; i < 4; i++, pos_++ )
+		{
+			auto c = peek();
+			code <<= 4;
+			if ( digit( c ) )
+			{
+				code |= c - '0';
+			}
+			else if ( c >= 'a' && c <= 'f' )
+			{
+				code |= c - 'a' + 10;
+			}
+			else if ( c >= 'A' && c <= 'F' )
+			{
+				code |= c - 'A' + 10;
+			}
+			else
+			{
+				return fail();
+			}
+		}
+		return true;
+	}
+
+	size_t add( Op op, size_t lhs = 0, size_t rhs = 0 )
+	{
+		nodes_.push_back( Node{ op, lhs, rhs, Value(), Query() } );
+		return nodes_.size() - 1;
+	}
+
+	bool logical_or( size_t &node )
+	{
+		if ( !logical_and( node ) )
+		{
+			return false;
+		}
+		skip_spaces();
+		while( peek() == '|' && peek( 1 ) == '|' )
+		{
+			pos_ += 2;
+			size_t rhs = 0;
+			if ( !logical_and( rhs ) )
+			{
+				return false;
+			}
+			node = add( Op::Or, node, rhs );
+			skip_spaces();
+		}
+		return true;
+	}
+
+	bool logical_and( size_t &node )
+	{
+		if ( !logical_not( node ) )
+		{
+			return false;
+		}
+		skip_spaces();
+		while( peek() == '&' && peek( 1 ) == '&' )
+		{
+			pos_ += 2;
+			size_t rhs = 0;
+			if ( !logical_not( rhs ) )
+			{
+				return false;
+			}
+			node = add( Op::And, node, rhs );
+			skip_spaces();
+		}
+		return true;
+	}
+
+	bool logical_not( size_t &node )
+	{
+		skip_spaces();
+		if ( peek() == '!' && peek( 1 ) != '=' )
+		{
+			pos_++;
+			if ( !logical_not( node ) )
+			{
+				return false;
+			}
+			node = add( Op::Not, node );
+			return true;
+		}
+		return comparison( node );
+	}
+
+	bool comparison( size_t &node )
+	{
+		if ( !primary( node ) )
+		{
+			return false;
+		}
+		skip_spaces();
+		auto at = pos_;
+		Op op = Op::Literal;
+		auto c = peek();
+		auto next = peek( 1 );
+		if ( c == '=' && next == '=' )      { op = Op::Eq; pos_ += 2; }
+		else if ( c == '!' && next == '=' ) { op = Op::Ne; pos_ += 2; }
+		else if ( c == '<' && next == '=' ) { op = Op::Le; pos_ += 2; }
+		else if ( c == '>' && next == '=' ) { op = Op::Ge; pos_ += 2; }
+		else if ( c == '<' )                { op = Op::Lt; pos_ += 1; }
+		else if ( c == '>' )                { op = Op::Gt; pos_ += 1; }
+
+		auto kind = nodes_[node].op;
+		auto comparable = kind == Op::Literal || ( kind == Op::Query && singular( nodes_[node].query ) );
+		if ( op == Op::Literal )
+		{
+			// Bare query tests existence, bare literal means nothing
+			if ( kind == Op::Query )
+			{
+				node = add( Op::Exists, node );
+			}
+			else if ( kind == Op::Literal )
+			{
+				return fail();
+			}
+			return true;
+		}
+		// Only literals and singular queries may be compared
+		if ( !comparable )
+		{
+			pos_ = at;
+			return fail();
+		}
+		size_t rhs = 0;
+		auto start = pos_;
+		if ( !primary( rhs ) )
+		{
+			return false;
+		}
+		if ( nodes_[rhs].op != Op::Literal && ( nodes_[rhs].op != Op::Query || !singular( nodes_[rhs].query ) ) )
+		{
+			pos_ = start;
+			return fail();
+		}
+		node = add( op, node, rhs );
+		return true;
+	}
+
+	// Singular query selects at most one value, it only has name and index selectors, one per step
+	static bool singular( const Query &q )
+	{
+		for( const auto &step : q.steps )
+		{
+			if ( step.descendant || step.selectors.size() != 1 ||
+				 ( step.selectors[0].kind != Selector::Kind::Name && step.selectors[0].kind != Selector::Kind::Index ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool primary( size_t &node )
+	{
+		skip_spaces();
+		auto c = peek();
+		if ( c == '(' )
+		{
+			pos_++;
+			if ( !logical_or( node ) )
+			{
+				return false;
+			}
+			skip_spaces();
+			return expect( ')' );
+		}
+		if ( c == '@' || c == '$' )
+		{
+			pos_++;
+			node = add( Op::Query );
+			Query q;
+			q.absolute = c == '$';
+			if ( !query( q ) )
+			{
+				return false;
+			}
+			nodes_[node].query = std::move( q );
+			return true;
+		}
+		node = add( Op::Literal );
+		if ( c == '\'' || c == '"' )
+		{
+			std::string s;
+			if ( !string( s ) )
+			{
+				return false;
+			}
+			nodes_[node].literal = std::move( s );
+			return true;
+		}
+		if ( c == '-' || digit( c ) )
+		{
+			auto start = pos_;
+			bool integral = true;
+			while( digit( peek() ) || peek() == '-' || peek() == '+' || peek() == '.' || peek() == 'e' || peek() == 'E' )
+			{
+				integral = integral && ( digit( peek() ) || peek() == '-' );
+				pos_++;
+			}
+			Value number( text_->substr( start, pos_ - start ) );
+			Value::Int i = 0;
+			Value::Float f = 0.0;
+			if ( integral && number.try_get( i ) )
+			{
+				nodes_[node].literal = i;
+			}
+			else if ( number.try_get( f ) )
+			{
+				nodes_[node].literal = f;
+			}
+			else
+			{
+				pos_ = start;
+				return fail();
+			}
+			return true;
+		}
+		static const char *words[] = { "true", "false", "null" };
+		for( auto word : words )
+		{
+			auto n = std::strlen( word );
+			if ( text_->compare( pos_, n, word ) == 0 && !name_first( peek( n ) ) && !digit( peek( n ) ) )
+			{
+				pos_ += n;
+				if ( word[0] != 'n' )
+				{
+					nodes_[node].literal = word[0] == 't';
+				}
+				return true;
+			}
+		}
+		return fail();
+	}
+};
+
+JsonPath::JsonPath() :
+	impl_( new Impl() )
+{}
+
+JsonPath::JsonPath( const std::string &path, Error &e ) :
+	impl_( new Impl() )
+{
+	impl_->init( path, e );
+}
+
+JsonPath::~JsonPath()
+{}
+
+bool JsonPath::init( const std::string &path, Error &e )
+{
+	return impl_->init( path, e );
+}
+
+void JsonPath::select( const Value &root, std::vector<const Value*> &result ) const
+{
+	if ( impl_->valid_ )
+	{
+		auto f = [&result]( const Value &v ) { result.push_back( &v ); return true; };
+		impl_->walk( impl_->path_.steps, 0, root, root, f );
+	}
+}
+
+void JsonPath::select( Value &root, std::vector<Value*> &result ) const
+{
+	if ( impl_->valid_ )
+	{
+		auto f = [&result]( Value &v ) { result.push_back( &v ); };
+		impl_->walk( root, true, f );
+	}
+}
+
+const Value* JsonPath::first( const Value &root ) const
+{
+	return impl_->valid_ ? impl_->first( impl_->path_, root, root ) : nullptr;
+}
+
+Value* JsonPath::first( Value &root ) const
+{
+	Value *found = nullptr;
+	if ( impl_->valid_ )
+	{
+		auto f = [&found]( Value &v ) { found = &v; };
+		impl_->walk( root, false, f );
+	}
+	return found;
+}
+
+} // namespace jsoncpp
@@ -0,0 +1,192 @@
+
+#include "pointer.hpp"
+
+namespace jsoncpp
+{
+
+const size_t JsonPointer::npos_;
+const size_t JsonPointer::append_;
+
+JsonPointer::JsonPointer()
+{}
+
+JsonPointer::JsonPointer( const std::string &pointer, Error &e )
+{
+	init( pointer, e );
+}
+
+bool JsonPointer::init( const std::string &pointer, Error &e )
+{
+	text_.clear();
+	tokens_.clear();
+	if ( pointer.empty() )
+	{
+		return true;
+	}
+	if ( pointer[0] != '/' )
+	{
+		e = Error( Error::UnexpectedCharacter, "Pointer must start with '/' (0)" );
+		return false;
+	}
+
+	std::vector<Token> tokens;
+	std::string token;
+	for( size_t i = 1; i <= pointer.size(); i++ )
+	{
+		if ( i == pointer.size() || pointer[i] == '/' )
+		{
+			size_t index = npos_;
+			if ( token == "-" )
+			{
+				index = append_;
+			}
+			else if ( !token.empty() && token.size() < 19 && ( token[0] != '0' || token.size() == 1 ) &&
+					  token.find_first_not_of( "0123456789" ) == std::string::npos )
+			{
+				index = std::stoull( token );
+			}
+			tokens.push_back( Token{ Key( std::move( token ) ), index } );
+			token.clear();
+		}
+		else if ( pointer[i] == '~' )
+		{
+			if ( i + 1 < pointer.size() && ( pointer[i + 1] == '0' || pointer[i + 1] == '1' ) )
+			{
+				token += pointer[++i] == '0' ? '~' : '/';
+			}
+			else
+			{
+				e = Error( Error::UnexpectedCharacter, "Bad escape sequence (%u)", (unsigned)i );
+				return false;
+			}
+		}
+		else
+		{
+			token += pointer[i];
+		}
+	}
+	text_ = pointer;
+	tokens_ = std::move( tokens );
+	return true;
+}
+
+const std::string& JsonPointer::str() const
+{
+	return text_;
+}
+
+size_t JsonPointer::size() const
+{
+	return tokens_.size();
+}
+
+template <typename V>
+V* JsonPointer::lookup( V &root ) const
+{
+	auto v = &root;
+	for( const auto &token : tokens_ )
+	{
+		if ( v->is_object() )
+		{
+			auto &o = v->get_object();
+			auto i = o.find( token.key );
+			if ( i == o.end() )
+			{
+				return nullptr;
+			}
+			v = &i->second;
+		}
+		else if ( v->is_array() && token.index < v->size() )
+		{
+			v = &v->get_array()[token.index];
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+	return v;
+}
+
+const Value* JsonPointer::find( const Value &root ) const
+{
+	return lookup( root );
+}
+
+Value* JsonPointer::find( Value &root ) const
+{
+	return lookup( root );
+}
+
+// Missing values are always created, so only existing part of the path can make create() fail
+bool JsonPointer::creatable( const Value &root ) const
+{
+	auto v = &root;
+	for( const auto &token : tokens_ )
+	{
+		if ( v->is_none() )
+		{
+			return true;
+		}
+		if ( v->is_object() )
+		{
+			auto &o = v->get_object();
+			auto i = o.find( token.key );
+			if ( i == o.end() )
+			{
+				return true;
+			}
+			v = &i->second;
+		}
+		else if ( v->is_array() && ( token.index == append_ || token.index == v->size() ) )
+		{
+			return true;
+		}
+		else if ( v->is_array() && token.index < v->size() )
+		{
+			v = &v->get_array()[token.index];
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+Value* JsonPointer::create( Value &root ) const
+{
+	if ( !creatable( root ) )
+	{
+		return nullptr;
+	}
+	auto v = &root;
+	auto resource = root.resource();
+	for( const auto &token : tokens_ )
+	{
+		if ( v->is_none() )
+		{
+			*v = Value( token.index == append_ ? Value::Type::Array : Value::Type::Object, resource );
+		}
+		resource = v->resource();
+		if ( v->is_object() )
+		{
+			v = &v->get_object().emplace( token.key, Value() ).first->second;
+		}
+		else if ( v->is_array() && ( token.index == append_ || token.index == v->size() ) )
+		{
+			v = &v->insert( Value() ).back();
+		}
+		else if ( v->is_array() && token.index < v->size() )
+		{
+			v = &v->get_array()[token.index];
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+	return v;
+}
+
+} // namespace jsoncpp
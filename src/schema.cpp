@@ -3,6 +3,7 @@
 #include <regex>
 #include "json.hpp"
 #include "schema.hpp"
+#include "variant.hpp"
 
 namespace jsoncpp
 {
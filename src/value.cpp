@@ -1,6 +1,8 @@
 
 #include "value.hpp"
+#include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <cerrno>
 #include <limits>
 #include <inttypes.h>
@@ -9,7 +11,246 @@
 namespace jsoncpp
 {
 
-static Value none;
+// Missing elements of const values are looked up as a shared immutable value
+static const Value none;
+
+// Missing elements of mutable values are returned as a per-thread value,
+// which is reset on every use, since callers may have modified it
+static Value& missing()
+{
+	static thread_local Value value;
+	value.clear();
+	return value;
+}
+
+// Final avalanche step of MurmurHash3
+static uint64_t mix( uint64_t h )
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// String hash, consumes eight bytes per step
+static uint64_t hash_bytes( const char *s, size_t n )
+{
+	const uint64_t k = 0x9e3779b97f4a7c15ull;
+	uint64_t h = n * k;
+	for( ; n >= 8; s += 8, n -= 8 )
+	{
+		uint64_t word;
+		std::memcpy( &word, s, 8 );
+		h = ( h ^ mix( word ) ) * k;
+	}
+	if ( n > 0 )
+	{
+		uint64_t word = 0;
+		std::memcpy( &word, s, n );
+		h = ( h ^ mix( word ) ) * k;
+	}
+	return mix( h );
+}
+
+// Object keys hash like Key, which has it precalculated
+#ifdef JSONCPP_SORTED_OBJECT
+static uint64_t hash_key( const std::string &key )
+{
+	return Key::hash( key.data(), key.size() );
+}
+#else
+static uint64_t hash_key( const Key &key )
+{
+	return key.hash();
+}
+#endif
+
+// Case insensitive comparison with lowercase literal
+static bool equals_lower( const StringRef &s, const char *lower )
+{
+	size_t i = 0;
+	for( ; i < s.size() && lower[i]; i++ )
+	{
+		if ( tolower( (unsigned char)s[i] ) != lower[i] )
+		{
+			return false;
+		}
+	}
+	return i == s.size() && !lower[i];
+}
+
+#ifdef JSONCPP_SORTED_OBJECT
+// C++11 std::map has no heterogeneous lookup, so sorted objects copy key into per thread string,
+// which keeps its capacity between lookups.
+static const std::string& lookup_key( const StringRef &key )
+{
+	static thread_local std::string lookup;
+	lookup.assign( key.data(), key.size() );
+	return lookup;
+}
+#endif
+
+// Finds object member by key without building a key object.
+template <typename Map>
+static auto find_member( Map &o, const StringRef &key ) -> decltype( o.begin() )
+{
+#ifdef JSONCPP_SORTED_OBJECT
+	return o.find( lookup_key( key ) );
+#else
+	return o.find( key );
+#endif
+}
+
+// Finds object member by string key, sorted objects look it up as it is
+template <typename Map>
+static auto find_member( Map &o, const std::string &key ) -> decltype( o.begin() )
+{
+#ifdef JSONCPP_SORTED_OBJECT
+	return o.find( key );
+#else
+	return o.find( StringRef( key ) );
+#endif
+}
+
+// Parses [+-]digits, rejecting out of range values
+static bool parse_int( const StringRef &s, Value::Int &out )
+{
+	size_t i = 0;
+	bool negative = false;
+	if ( i < s.size() && ( s[i] == '-' || s[i] == '+' ) )
+	{
+		negative = s[i++] == '-';
+	}
+	if ( i == s.size() )
+	{
+		return false;
+	}
+	uint64_t limit = negative ? (uint64_t)std::numeric_limits<Value::Int>::max() + 1 : (uint64_t)std::numeric_limits<Value::Int>::max();
+	uint64_t n = 0;
+	for( ; i < s.size(); i++ )
+	{
+		unsigned digit = (unsigned char)s[i] - '0';
+		if ( digit > 9 || n > ( limit - digit ) / 10 )
+		{
+			return false;
+		}
+		n = n * 10 + digit;
+	}
+	out = negative ? (Value::Int)( 0 - n ) : (Value::Int)n;
+	return true;
+}
+
+// Parses [+-]digits[.digits][(e|E)[+-]digits], rejecting overflow and underflow.
+// Decimal point is never passed to strtod(), so the result doesn't depend on locale.
+static bool parse_float( const StringRef &s, Value::Float &out )
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+									  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	// Longest decimal needed to round any double correctly, see "How to Read Floating Point Numbers Accurately"
+	static const size_t max_digits = 780;
+	char digits[max_digits + 2];
+	size_t count = 0;
+	bool truncated = false;
+	long exponent = 0;
+	size_t mantissa = 0;
+	size_t i = 0;
+	bool negative = false;
+	if ( i < s.size() && ( s[i] == '-' || s[i] == '+' ) )
+	{
+		negative = s[i++] == '-';
+	}
+	for( bool fraction = false; i < s.size(); i++ )
+	{
+		if ( s[i] == '.' && !fraction )
+		{
+			fraction = true;
+			continue;
+		}
+		if ( s[i] < '0' || s[i] > '9' )
+		{
+			break;
+		}
+		mantissa++;
+		if ( count == 0 && s[i] == '0' )
+		{
+			exponent -= fraction ? 1 : 0;
+			continue;
+		}
+		if ( count < max_digits )
+		{
+			digits[count++] = s[i];
+			exponent -= fraction ? 1 : 0;
+		}
+		else
+		{
+			truncated = truncated || s[i] != '0';
+			exponent += fraction ? 0 : 1;
+		}
+	}
+	if ( mantissa == 0 )
+	{
+		return false;
+	}
+	if ( i < s.size() && ( s[i] == 'e' || s[i] == 'E' ) )
+	{
+		i++;
+		bool negative_exponent = false;
+		if ( i < s.size() && ( s[i] == '-' || s[i] == '+' ) )
+		{
+			negative_exponent = s[i++] == '-';
+		}
+		if ( i == s.size() )
+		{
+			return false;
+		}
+		long e = 0;
+		for( ; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++ )
+		{
+			e = std::min( e * 10 + ( s[i] - '0' ), 100000l );
+		}
+		exponent += negative_exponent ? -e : e;
+	}
+	if ( i != s.size() )
+	{
+		return false;
+	}
+
+	Value::Float f = 0.0;
+	if ( count == 0 )
+	{
+		f = 0.0;
+	}
+	else if ( count <= 15 && exponent >= -22 && exponent <= 22 )
+	{
+		// Mantissa and power of ten are exact, so single operation rounds correctly
+		uint64_t m = 0;
+		for( size_t j = 0; j < count; j++ )
+		{
+			m = m * 10 + ( digits[j] - '0' );
+		}
+		f = exponent < 0 ? (Value::Float)m / powers[-exponent] : (Value::Float)m * powers[exponent];
+	}
+	else
+	{
+		if ( truncated )
+		{
+			digits[count++] = '1';
+			exponent--;
+		}
+		char text[max_digits + 32];
+		snprintf( text, sizeof( text ), "%.*se%ld", (int)count, digits, exponent );
+		errno = 0;
+		f = strtod( text, nullptr );
+		if ( errno != 0 )
+		{
+			return false;
+		}
+	}
+	out = negative ? -f : f;
+	return true;
+}
 
 const Value::Int Value::default_int_ = 0;
 const Value::Float Value::default_float_ = 0.0f;
@@ -23,69 +264,368 @@ Value::Value() :
 {}
 
 Value::Value( const Value::Type t ) :
-	type_( t )
+	Value( t, default_resource() )
+{}
+
+Value::Value( const Value::Type t, MemoryResource *resource ) :
+	type_( Value::Type::None )
 {
 	switch( t )
 	{
 	case Value::Type::None:
 		break;
 	case Value::Type::Int:
-		data_ = default_value<Int>();
+		set( default_value<Int>() );
 		break;
 	case Value::Type::Float:
-		data_ = default_value<Float>();
+		set( default_value<Float>() );
 		break;
 	case Value::Type::Bool:
-		data_ = default_value<Bool>();
+		set( default_value<Bool>() );
 		break;
 	case Value::Type::String:
-		data_ = default_value<String>();
+		set( "", 0, resource );
 		break;
 	case Value::Type::Array:
-		data_ = default_value<Array>();
+		set( Array( Allocator<Value>( resource ) ) );
 		break;
 	case Value::Type::Object:
-		data_ = default_value<Object>();
+		set( Object( Object::allocator_type( resource ) ) );
 		break;
 	}
 }
 
-Value::Value( const char *s )
+Value::Value( const char *s ) :
+	type_( Value::Type::None )
 {
-	type_ = Type::String;
-	data_ = String( s );
+	set( s, std::strlen( s ), default_resource() );
 }
 
 Value::Value( const Value &rhs ) :
-	type_( rhs.type_ ),
-	data_( rhs.data_ )
+	Value( rhs, rhs.resource() )
+{}
+
+Value::Value( const Value &rhs, MemoryResource *resource ) :
+	type_( Value::Type::None )
+{
+	switch( rhs.type_ )
+	{
+	case Value::Type::String:
+		if ( rhs.is_small() || share_box( rhs.data().string_, resource ) )
+		{
+			std::memcpy( cell_, rhs.cell_, sizeof( cell_ ) );
+			type_ = rhs.type_;
+		}
+		else
+		{
+			auto &str = rhs.data().string_->value;
+			set( str.data(), str.size(), resource );
+		}
+		break;
+	case Value::Type::Array:
+		if ( share_box( rhs.data().array_, resource ) )
+		{
+			std::memcpy( cell_, rhs.cell_, sizeof( cell_ ) );
+			type_ = rhs.type_;
+		}
+		else
+		{
+			set( rhs.data().array_->value, resource );
+		}
+		break;
+	case Value::Type::Object:
+		if ( share_box( rhs.data().object_, resource ) )
+		{
+			std::memcpy( cell_, rhs.cell_, sizeof( cell_ ) );
+			type_ = rhs.type_;
+		}
+		else
+		{
+			set( rhs.data().object_->value, resource );
+		}
+		break;
+	default:
+		std::memcpy( cell_, rhs.cell_, sizeof( cell_ ) );
+		type_ = rhs.type_;
+		break;
+	}
+}
+
+Value::Value( String &&value, MemoryResource *resource ) :
+	type_( Value::Type::None )
+{
+	set( std::move( value ), resource );
+}
+
+Value::~Value()
+{
+	clear();
+}
+
+template <typename T, typename ...Args>
+Value::Box<T>* Value::make_box( MemoryResource *resource, Args&&... args )
+{
+	void *p = resource->allocate( sizeof( Box<T> ), alignof( Box<T> ) );
+	try
+	{
+		return new( p ) Box<T>( resource, std::forward<Args>( args )... );
+	}
+	catch( ... )
+	{
+		resource->deallocate( p, sizeof( Box<T> ), alignof( Box<T> ) );
+		throw;
+	}
+}
+
+template <typename T>
+void Value::release_box( Box<T> *box )
+{
+	if ( box->refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+	{
+		auto resource = box->resource;
+		box->~Box<T>();
+		resource->deallocate( box, sizeof( Box<T> ), alignof( Box<T> ) );
+	}
+}
+
+template <typename T>
+bool Value::share_box( Box<T> *box, MemoryResource *resource )
+{
+	if ( !box->shareable || !box->resource->is_equal( *resource ) )
+	{
+		return false;
+	}
+	box->refs.fetch_add( 1, std::memory_order_relaxed );
+	return true;
+}
+
+void Value::set( const None& )
+{
+	clear();
+}
+
+void Value::set( const Int &value )
+{
+	data().int_ = value;
+	type_ = Type::Int;
+}
+
+void Value::set( const Float &value )
+{
+	data().float_ = value;
+	type_ = Type::Float;
+}
+
+void Value::set( const Bool &value )
 {
+	data().bool_ = value;
+	type_ = Type::Bool;
 }
 
-void Value::swap( Value &rhs )
+void Value::set( const String &value )
 {
-	auto t = type_;
-	auto d = std::move( data_ );
-	type_ = rhs.type_;
-	data_ = rhs.data_;
-	rhs.type_ = t;
-	rhs.data_ = std::move( d );
+	set( value.data(), value.size(), default_resource() );
 }
 
-void Value::swap( Value &&rhs )
+void Value::set( const Array &value )
 {
-	auto t = type_;
-	auto d = std::move( data_ );
-	type_ = rhs.type_;
-	data_ = rhs.data_;
-	rhs.type_ = t;
-	rhs.data_ = std::move( d );
+	set( value, value.get_allocator().resource() );
+}
+
+void Value::set( const Object &value )
+{
+	set( value, value.get_allocator().resource() );
+}
+
+void Value::set( String &&value )
+{
+	set( std::move( value ), default_resource() );
+}
+
+void Value::set( Array &&value )
+{
+	data().array_ = make_box<Array>( value.get_allocator().resource(), std::move( value ) );
+	type_ = Type::Array;
+}
+
+void Value::set( Object &&value )
+{
+	data().object_ = make_box<Object>( value.get_allocator().resource(), std::move( value ) );
+	type_ = Type::Object;
+}
+
+void Value::set( const char *s, size_t n, MemoryResource *resource )
+{
+	if ( n <= small_capacity_ )
+	{
+		std::memcpy( cell_, s, n );
+		cell_[small_capacity_] = (char)n;
+	}
+	else
+	{
+		data().string_ = make_box<String>( resource, s, n );
+		cell_[small_capacity_] = (char)heap_string_;
+	}
+	type_ = Type::String;
+}
+
+void Value::set( String &&value, MemoryResource *resource )
+{
+	if ( value.size() <= small_capacity_ )
+	{
+		set( value.data(), value.size(), resource );
+		return;
+	}
+	data().string_ = make_box<String>( resource, std::move( value ) );
+	cell_[small_capacity_] = (char)heap_string_;
+	type_ = Type::String;
+}
+
+// Deep copy, all nested payloads are allocated from the resource
+void Value::set( const Array &value, MemoryResource *resource )
+{
+	Array arr( ( Allocator<Value>( resource ) ) );
+	arr.reserve( value.size() );
+	for( const auto &i : value )
+	{
+		arr.emplace_back( i, resource );
+	}
+	set( std::move( arr ) );
+}
+
+void Value::set( const Object &value, MemoryResource *resource )
+{
+	Object obj( ( Object::allocator_type( resource ) ) );
+	for( const auto &i : value )
+	{
+		obj.emplace( i.first, Value( i.second, resource ) );
+	}
+	set( std::move( obj ) );
+}
+
+Value::String* Value::ptr( String* )
+{
+	if ( type_ != Type::String )
+	{
+		return nullptr;
+	}
+	if ( is_small() )
+	{
+		// Mutable access needs a real std::string, so the value moves to the heap
+		auto box = make_box<String>( default_resource(), cell_, (size_t)(uint8_t)cell_[small_capacity_] );
+		data().string_ = box;
+		cell_[small_capacity_] = (char)heap_string_;
+	}
+	detach();
+	data().string_->shareable = false;
+	return &data().string_->value;
+}
+
+Value::Array* Value::ptr( Array* )
+{
+	if ( type_ != Type::Array )
+	{
+		return nullptr;
+	}
+	detach();
+	data().array_->shareable = false;
+	return &data().array_->value;
+}
+
+Value::Object* Value::ptr( Object* )
+{
+	if ( type_ != Type::Object )
+	{
+		return nullptr;
+	}
+	detach();
+	data().object_->shareable = false;
+	return &data().object_->value;
+}
+
+// Gives the value its own copy of a shared payload. Elements of copied containers stay shared.
+// Every mutation goes through here, so cached hash is dropped as well.
+void Value::detach()
+{
+	switch( type_ )
+	{
+	case Type::String:
+		if ( is_small() )
+		{
+			break;
+		}
+		if ( data().string_->refs.load( std::memory_order_acquire ) > 1 )
+		{
+			auto box = data().string_;
+			data().string_ = make_box<String>( box->resource, box->value );
+			release_box( box );
+		}
+		data().string_->hash.store( 0, std::memory_order_relaxed );
+		break;
+	case Type::Array:
+		if ( data().array_->refs.load( std::memory_order_acquire ) > 1 )
+		{
+			auto box = data().array_;
+			data().array_ = make_box<Array>( box->resource, box->value );
+			release_box( box );
+		}
+		data().array_->hash.store( 0, std::memory_order_relaxed );
+		break;
+	case Type::Object:
+		if ( data().object_->refs.load( std::memory_order_acquire ) > 1 )
+		{
+			auto box = data().object_;
+			data().object_ = make_box<Object>( box->resource, box->value );
+			release_box( box );
+		}
+		data().object_->hash.store( 0, std::memory_order_relaxed );
+		break;
+	default:
+		break;
+	}
+}
+
+// Mutable access, which keeps payload shareable. References must not outlive the call site.
+Value::Array& Value::array_ref()
+{
+	detach();
+	return data().array_->value;
+}
+
+Value::Object& Value::object_ref()
+{
+	detach();
+	return data().object_->value;
+}
+
+void Value::swap( Value &rhs ) noexcept
+{
+	std::swap( cell_, rhs.cell_ );
+	std::swap( type_, rhs.type_ );
+}
+
+void Value::swap( Value &&rhs ) noexcept
+{
+	swap( rhs );
 }
 
 Value& Value::operator=( const Value &value )
 {
-	data_ = value.data_;
-	type_ = value.type_;
+	if ( this != &value )
+	{
+		Value tmp( value );
+		swap( tmp );
+	}
+	return *this;
+}
+
+Value& Value::operator=( Value &&value ) noexcept
+{
+	if ( this != &value )
+	{
+		Value tmp( std::move( value ) );
+		swap( tmp );
+	}
 	return *this;
 }
 
@@ -149,10 +689,105 @@ bool Value::operator==( const float &value ) const
 	return get_float() == (Float)value;
 }
 
+bool Value::operator==( const String &value ) const
+{
+	return type_ == Type::String && string_ref() == StringRef( value );
+}
+
 bool Value::operator==( const char *value ) const
 {
-	auto v = Value( value );
-	return operator==( v );
+	return type_ == Type::String && string_ref() == StringRef( value );
+}
+
+uint64_t Value::hash() const
+{
+	switch( type_ )
+	{
+	case Type::String:
+		return is_small() ? compute_hash() : box_hash( data().string_ );
+	case Type::Array:
+		return box_hash( data().array_ );
+	case Type::Object:
+		return box_hash( data().object_ );
+	default:
+		return compute_hash();
+	}
+}
+
+// Cache is only trusted while payload is shareable, since mutable references may change it any time
+template <typename T>
+uint64_t Value::box_hash( Box<T> *box ) const
+{
+	uint64_t h = box->hash.load( std::memory_order_relaxed );
+	if ( h != 0 && box->shareable )
+	{
+		return h;
+	}
+	h = compute_hash();
+	if ( box->shareable )
+	{
+		box->hash.store( h, std::memory_order_relaxed );
+	}
+	return h;
+}
+
+template <typename T>
+bool Value::hash_differs( const Box<T> *lhs, const Box<T> *rhs )
+{
+	uint64_t l = lhs->hash.load( std::memory_order_relaxed );
+	uint64_t r = rhs->hash.load( std::memory_order_relaxed );
+	return l != 0 && r != 0 && l != r && lhs->shareable && rhs->shareable;
+}
+
+uint64_t Value::compute_hash() const
+{
+	const uint64_t k = 0x9e3779b97f4a7c15ull;
+	const uint64_t seed = mix( (uint64_t)type_ + 1 );
+	switch( type_ )
+	{
+	case Type::Int:
+		return mix( seed ^ (uint64_t)data().int_ );
+	case Type::Float:
+	{
+		// Numbers compare equal within epsilon, which may join different bit patterns only up to 1
+		Float f = data().float_;
+		if ( std::fabs( f ) <= 1 )
+		{
+			return seed;
+		}
+		uint64_t bits;
+		std::memcpy( &bits, &f, sizeof( bits ) );
+		return mix( seed ^ bits );
+	}
+	case Type::Bool:
+		return mix( seed + ( data().bool_ ? 1 : 2 ) );
+	case Type::String:
+	{
+		auto s = string_ref();
+		return mix( seed ^ hash_bytes( s.data(), s.size() ) );
+	}
+	case Type::Array:
+	{
+		uint64_t h = seed;
+		for( auto &element : data().array_->value )
+		{
+			h = mix( ( h ^ element.hash() ) * k );
+		}
+		return h;
+	}
+	case Type::Object:
+	{
+		// Sum of member hashes doesn't depend on member order
+		uint64_t sum = 0;
+		for( auto &member : data().object_->value )
+		{
+			sum += mix( member.second.hash() * k + hash_key( member.first ) );
+		}
+		return mix( seed ^ sum );
+	}
+	default:
+		return seed;
+	}
 }
 
 bool Value::operator==( const Value &value ) const
@@ -162,26 +797,35 @@ bool Value::operator==( const Value &value ) const
 		return false;
 	}
 	bool ret = true;
-	switch( data_.type_index() )
+	switch( type_ )
 	{
-	case 1:
+	case Type::None:
 		break;
-	case 2:
+	case Type::Bool:
 		ret = get_bool() == value.get_bool();
 		break;
-	case 3:
+	case Type::Int:
 		ret = get_int() == value.get_int();
 		break;
-	case 4:
+	case Type::Float:
 		ret = ( std::fabs( get_float() - value.get_float() ) < std::numeric_limits<Float>::epsilon() );
 		break;
-	case 5:
-		ret = get_string() == value.get_string();
+	case Type::String:
+		ret = ( !is_small() && data().string_ == value.data().string_ ) || string_ref() == value.string_ref();
 		break;
-	case 6:
+	case Type::Array:
 	{
-		const auto that = get_array();
-		const auto v = value.get_array();
+		if ( data().array_ == value.data().array_ )
+		{
+			break;
+		}
+		if ( hash_differs( data().array_, value.data().array_ ) )
+		{
+			ret = false;
+			break;
+		}
+		const auto &that = get_array();
+		const auto &v = value.get_array();
 		if ( that.size() != v.size() )
 		{
 			ret = false;
@@ -199,10 +843,19 @@ bool Value::operator==( const Value &value ) const
 		}
 		break;
 	}
-	case 7:
+	case Type::Object:
 	{
-		const auto that = get_object();
-		const auto v = value.get_object();
+		if ( data().object_ == value.data().object_ )
+		{
+			break;
+		}
+		if ( hash_differs( data().object_, value.data().object_ ) )
+		{
+			ret = false;
+			break;
+		}
+		const auto &that = get_object();
+		const auto &v = value.get_object();
 		if ( that.size() != v.size() )
 		{
 			ret = false;
@@ -221,8 +874,6 @@ bool Value::operator==( const Value &value ) const
 		}
 		break;
 	}
-	default:
-		break;
 	}
 	return ret;
 }
@@ -244,53 +895,57 @@ Value& Value::operator[]( int index )
 
 Value& Value::at( unsigned index )
 {
-	auto &arr = get<Array>();
-	if ( type_ != Type::Array || arr.size() <= index )
+	if ( type_ != Type::Array || size() <= index )
 	{
-		none.clear();
-		return none;
+		return missing();
 	}
-	return arr.at( index );
+	return get<Array>()[index];
 }
 
 Value& Value::at( int index )
 {
-	auto &arr = get<Array>();
-	if ( type_ != Type::Array || arr.size() <= (size_t)index )
+	if ( index < 0 )
 	{
-		none.clear();
-		return none;
+		return missing();
 	}
-	return arr.at( (size_t)index );
+	return at( (unsigned)index );
 }
 
 Value& Value::back()
 {
-	auto &arr = get<Array>();
-	if ( type_ != Type::Array || arr.size() == 0 )
+	if ( type_ != Type::Array || size() == 0 )
 	{
-		none.clear();
-		return none;
+		return missing();
 	}
-	return arr.at( arr.size() - 1 );
+	return get<Array>().back();
+}
+
+Value& Value::operator[]( const std::string &key )
+{
+	return at( key );
+}
+
+const Value& Value::operator[]( const std::string &key ) const
+{
+	return at( key );
 }
 
-Value& Value::operator[]( const std::string &key )
+Value& Value::operator[]( const char *key )
 {
 	return at( key );
 }
 
-const Value& Value::operator[]( const std::string &key ) const
+const Value& Value::operator[]( const char *key ) const
 {
 	return at( key );
 }
 
-Value& Value::operator[]( const char *key )
+Value& Value::operator[]( const StringRef &key )
 {
 	return at( key );
 }
 
-const Value& Value::operator[]( const char *key ) const
+const Value& Value::operator[]( const StringRef &key ) const
 {
 	return at( key );
 }
@@ -308,22 +963,52 @@ Value& Value::at( const std::string &key )
 const Value& Value::at( const std::string &key ) const
 {
 	auto &o = get<Object>();
-	if ( type_ != Type::Object || o.find( key ) == o.end() )
+	auto i = find_member( o, key );
+	if ( i == o.end() )
 	{
-		none.clear();
 		return none;
 	}
-	return o.at( key );
+	return i->second;
 }
 
 Value& Value::at( const char *key )
 {
-	return at( std::string( key ) );
+	return at( StringRef( key ) );
 }
 
 const Value& Value::at( const char *key ) const
 {
-	return at( std::string( key ) );
+	return at( StringRef( key ) );
+}
+
+Value& Value::at( const StringRef &key )
+{
+	if ( type_ != Type::Object )
+	{
+		swap( Value( Type::Object ) );
+	}
+	auto &o = get<Object>();
+	auto i = find_member( o, key );
+	if ( i != o.end() )
+	{
+		return i->second;
+	}
+#ifdef JSONCPP_SORTED_OBJECT
+	return o[key.str()];
+#else
+	return o[Key( key.data(), key.size() )];
+#endif
+}
+
+const Value& Value::at( const StringRef &key ) const
+{
+	auto &o = get<Object>();
+	auto i = find_member( o, key );
+	if ( i == o.end() )
+	{
+		return none;
+	}
+	return i->second;
 }
 
 Value& Value::insert( Value &&v )
@@ -332,18 +1017,26 @@ Value& Value::insert( Value &&v )
 	{
 		swap( Value( Type::Array ) );
 	}
-	get<Array>().push_back( std::move( v ) );
+	auto &arr = array_ref();
+	auto resource = arr.get_allocator().resource();
+	if ( v.resource()->is_equal( *resource ) )
+	{
+		arr.push_back( std::move( v ) );
+	}
+	else
+	{
+		arr.emplace_back( v, resource );
+	}
 	return *this;
 }
 
 Value& Value::erase( unsigned index )
 {
-	auto &arr = get<Array>();
-	if ( type_ != Type::Array || arr.size() <= index )
+	if ( type_ != Type::Array || size() <= index )
 	{
-		none.clear();
-		return none;
+		return missing();
 	}
+	auto &arr = array_ref();
 	arr.erase( arr.begin() + index );
 	return *this;
 }
@@ -354,42 +1047,46 @@ Value& Value::insert( const std::string &key, Value &&v )
 	{
 		swap( Value( Type::Object ) );
 	}
-	get<Object>().insert( std::pair<std::string, Value>( key, std::move( v ) ) );
+	auto &o = object_ref();
+	auto resource = o.get_allocator().resource();
+	if ( v.resource()->is_equal( *resource ) )
+	{
+		o.emplace( key, std::move( v ) );
+	}
+	else
+	{
+		o.emplace( key, Value( v, resource ) );
+	}
 	return *this;
 }
 
 Value& Value::erase( const std::string &key )
 {
-	auto &o = get<Object>();
-	if ( type_ != Type::Object || o.find( key ) == o.end() )
+	if ( type_ != Type::Object || !has( key ) )
 	{
-		none.clear();
-		return none;
+		return missing();
 	}
-	o.erase( key );
+	object_ref().erase( key );
 	return *this;
 }
 
 Value::Type Value::type() const
 {
-	switch( data_.type_index() )
-	{
-	case 1:
-		return Type::None;
-	case 2:
-		return Type::Bool;
-	case 3:
-		return Type::Int;
-	case 4:
-		return Type::Float;
-	case 5:
-		return Type::String;
-	case 6:
-		return Type::Array;
-	case 7:
-		return Type::Object;
+	return type_;
+}
+
+MemoryResource* Value::resource() const
+{
+	switch( type_ )
+	{
+	case Type::String:
+		return is_small() ? default_resource() : data().string_->resource;
+	case Type::Array:
+		return data().array_->resource;
+	case Type::Object:
+		return data().object_->resource;
 	default:
-		return Type::None;
+		return default_resource();
 	}
 }
 
@@ -398,12 +1095,17 @@ bool Value::has( unsigned index ) const
 	return type_ == Type::Array && index < get<Value::Array>().size();
 }
 
+bool Value::has( int index ) const
+{
+	return index >= 0 && has( (unsigned)index );
+}
+
 bool Value::find( ElementPredicate pred, unsigned &index ) const
 {
 	bool res = false;
 	if ( type_ == Type::Array )
 	{
-		auto items = get<Value::Array>();
+		const auto &items = get<Value::Array>();
 		for( index = 0; index < items.size(); index++ )
 		{
 			if ( pred( items[index] ) )
@@ -418,13 +1120,63 @@ bool Value::find( ElementPredicate pred, unsigned &index ) const
 
 bool Value::has( const std::string &key ) const
 {
-	auto o = get<Value::Object>();
-	return type_ == Type::Object && o.find( key ) != o.end();
+	if ( type_ != Type::Object )
+	{
+		return false;
+	}
+	auto &o = get<Value::Object>();
+	return find_member( o, key ) != o.end();
+}
+
+bool Value::has( const char *key ) const
+{
+	return has( StringRef( key ) );
+}
+
+bool Value::has( const StringRef &key ) const
+{
+	if ( type_ != Type::Object )
+	{
+		return false;
+	}
+	auto &o = get<Value::Object>();
+	return find_member( o, key ) != o.end();
 }
 
 void Value::accept( ValueVisitor *visitor ) const
 {
-	data_.accept( *visitor );
+	switch( type_ )
+	{
+	case Type::None:
+		(*visitor)();
+		break;
+	case Type::Int:
+		(*visitor)( data().int_ );
+		break;
+	case Type::Float:
+		(*visitor)( data().float_ );
+		break;
+	case Type::Bool:
+		(*visitor)( data().bool_ );
+		break;
+	case Type::String:
+		if ( is_small() )
+		{
+			// Fits into std::string's own buffer, so nothing is allocated
+			(*visitor)( string_ref().str() );
+		}
+		else
+		{
+			(*visitor)( data().string_->value );
+		}
+		break;
+	case Type::Array:
+		(*visitor)( data().array_->value );
+		break;
+	case Type::Object:
+		(*visitor)( data().object_->value );
+		break;
+	}
 }
 
 bool Value::empty() const
@@ -434,31 +1186,46 @@ bool Value::empty() const
 
 void Value::clear()
 {
-	data_.clear();
+	switch( type_ )
+	{
+	case Type::String:
+		if ( !is_small() )
+		{
+			release_box( data().string_ );
+		}
+		break;
+	case Type::Array:
+		release_box( data().array_ );
+		break;
+	case Type::Object:
+		release_box( data().object_ );
+		break;
+	default:
+		break;
+	}
 	type_ = Type::None;
 }
 
 unsigned Value::size() const
 {
-	switch( data_.type_index() )
+	switch( type_ )
 	{
-	case 1:
+	case Type::None:
 		return 0u;
-	case 2:
+	case Type::Bool:
 		return sizeof( Bool );
-	case 3:
+	case Type::Int:
 		return sizeof( Int );
-	case 4:
+	case Type::Float:
 		return sizeof( Float );
-	case 5:
-		return get_string().size();
-	case 6:
-		return get_array().size();
-	case 7:
-		return get_object().size();
-	default:
-		return 0u;
+	case Type::String:
+		return string_ref().size();
+	case Type::Array:
+		return data().array_->value.size();
+	case Type::Object:
+		return data().object_->value.size();
 	}
+	return 0u;
 }
 
 bool Value::is( Type t ) const
@@ -475,121 +1242,61 @@ const Value::Object& Value::default_value( const Value::Object* ) { return defau
 
 Value Value::as( Type t ) const
 {
+	switch( t )
+	{
+	case Value::Type::Bool:  return Value( to_bool() );
+	case Value::Type::Int:   return Value( to_int() );
+	case Value::Type::Float: return Value( to_float() );
+	default: break;
+	}
+
 	Value v( t );
 	switch( type_ )
 	{
 	case Value::Type::None:
-		switch( t )
+		if ( t == Value::Type::String )
 		{
-		case Value::Type::None:   break;
-		case Value::Type::Bool:   break;
-		case Value::Type::Int:    break;
-		case Value::Type::Float:  break;
-		case Value::Type::String: v = "null"; break;
-		case Value::Type::Array:  break;
-		case Value::Type::Object: break;
+			v = "null";
 		}
 		break;
 	case Value::Type::Bool:
-		if ( is_convertable( t ) )
+		if ( t == Value::Type::String )
 		{
-			switch( t )
-			{
-			case Value::Type::None:   break;
-			case Value::Type::Bool:   v = (Bool)*data_.get<Bool>(); break;
-			case Value::Type::Int:    v = (Int)*data_.get<Bool>(); break;
-			case Value::Type::Float:  v = (Float)*data_.get<Bool>(); break;
-			case Value::Type::String: v = *data_.get<Bool>() ? "true": "false"; break;
-			case Value::Type::Array:  break;
-			case Value::Type::Object: break;
-			}
+			v = data().bool_ ? "true": "false";
 		}
 		break;
 	case Value::Type::Int:
-		if ( is_convertable( t ) )
+		if ( t == Value::Type::String )
 		{
-			switch( t )
-			{
-			case Value::Type::None:   break;
-			case Value::Type::Bool:   v = (Bool)*data_.get<Int>(); break;
-			case Value::Type::Int:    v = (Int)*data_.get<Int>(); break;
-			case Value::Type::Float:  v = (Float)*data_.get<Int>(); break;
-			case Value::Type::String:
-			{
-				char buf[21];
-				snprintf( buf, sizeof( buf ), "%" PRId64, *data_.get<Int>() );
-				v = std::string( buf );
-				break;
-			}
-			case Value::Type::Array:  break;
-			case Value::Type::Object: break;
-			}
+			char buf[21];
+			snprintf( buf, sizeof( buf ), "%" PRId64, data().int_ );
+			v = std::string( buf );
 		}
 		break;
 	case Value::Type::Float:
-		if ( is_convertable( t ) )
+		if ( t == Value::Type::String )
 		{
-			switch( t )
-			{
-			case Value::Type::None:   break;
-			case Value::Type::Bool:   v = (Bool)*data_.get<Float>(); break;
-			case Value::Type::Int:    v = (Int)*data_.get<Float>(); break;
-			case Value::Type::Float:  v = (Float)*data_.get<Float>(); break;
-			case Value::Type::String:
-			{
-				char buf[50];
-				snprintf( buf, sizeof( buf ), "%g", *data_.get<Float>() );
-				v = std::string( buf );
-				break;
-			}
-			case Value::Type::Array:  break;
-			case Value::Type::Object: break;
-			}
+			char buf[50];
+			snprintf( buf, sizeof( buf ), "%g", data().float_ );
+			v = std::string( buf );
 		}
 		break;
 	case Value::Type::String:
-		if ( is_convertable( t ) )
+		if ( t == Value::Type::String )
 		{
-			auto s = get<String>();
-			switch( t )
-			{
-			case Value::Type::None: break;
-			case Value::Type::Bool:
-			{
-				std::transform( s.begin(), s.end(), s.begin(), tolower );
-				v = ( s == "true" || s == "1" ) ? true : false;
-				break;
-			}
-			case Value::Type::Int:
-			{
-				v = (Value::Int)strtol( s.c_str(), nullptr, 10 );
-				break;
-			}
-			case Value::Type::Float:
-			{
-				v = (Value::Float)strtod( s.c_str(), nullptr );
-				break;
-			}
-			case Value::Type::String:
-			{
-				v = s;
-				break;
-			}
-			case Value::Type::Array:  break;
-			case Value::Type::Object: break;
-			}
+			v = *this;
 		}
 		break;
 	case Value::Type::Array:
 		if ( t == Value::Type::Array )
 		{
-			v = get<Array>();
+			v = *this;
 		}
 		break;
 	case Value::Type::Object:
 		if ( t == Value::Type::Object )
 		{
-			v = get<Object>();
+			v = *this;
 		}
 		break;
 	}
@@ -597,6 +1304,117 @@ Value Value::as( Type t ) const
 	return v;
 }
 
+Value::Int Value::to_int() const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		return (Int)data().bool_;
+	case Value::Type::Int:
+		return data().int_;
+	case Value::Type::String:
+	{
+		char buffer[small_capacity_ + 1];
+		auto s = c_str( buffer );
+		char* end_ptr = nullptr;
+		errno = 0;
+		auto ret = strtoll( s, &end_ptr, 10 );
+		if ( errno == 0 && end_ptr == s + string_ref().size() )
+		{
+			return (Int)ret;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return default_int_;
+}
+
+Value::Float Value::to_float() const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		return (Float)data().bool_;
+	case Value::Type::Int:
+		return (Float)data().int_;
+	case Value::Type::Float:
+		return data().float_;
+	case Value::Type::String:
+	{
+		char buffer[small_capacity_ + 1];
+		auto s = c_str( buffer );
+		char* end_ptr = nullptr;
+		errno = 0;
+		auto ret = strtod( s, &end_ptr );
+		if ( errno == 0 && end_ptr == s + string_ref().size() )
+		{
+			return (Float)ret;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return default_float_;
+}
+
+Value::Bool Value::to_bool() const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		return data().bool_;
+	case Value::Type::Int:
+		return (Bool)data().int_;
+	case Value::Type::Float:
+		return (Bool)data().float_;
+	case Value::Type::String:
+	{
+		auto s = string_ref();
+		return equals_lower( s, "true" ) || s == StringRef( "1" );
+	}
+	default:
+		break;
+	}
+	return default_bool_;
+}
+
+const char* Value::c_str( char (&buffer)[small_capacity_ + 1] ) const
+{
+	if ( type_ != Type::String )
+	{
+		return "";
+	}
+	if ( !is_small() )
+	{
+		return data().string_->value.c_str();
+	}
+	auto n = (uint8_t)cell_[small_capacity_];
+	std::memcpy( buffer, cell_, n );
+	buffer[n] = 0;
+	return buffer;
+}
+
+const Value::String& Value::string_value() const
+{
+	if ( type_ != Type::String )
+	{
+		return default_string_;
+	}
+	if ( !is_small() )
+	{
+		return data().string_->value;
+	}
+	// Slots are reused in turn, so several strings of one expression may be compared.
+	// Inline strings fit into std::string's own buffer, so assigning them doesn't allocate.
+	static thread_local String slots[4];
+	static thread_local unsigned next = 0;
+	String &slot = slots[next++ % 4];
+	slot.assign( cell_, (uint8_t)cell_[small_capacity_] );
+	return slot;
+}
 
 bool Value::is_convertable( const Value::Type t ) const
 {
@@ -656,25 +1474,26 @@ bool Value::is_convertable( const Value::Type t ) const
 		case Value::Type::None:   return true;
 		case Value::Type::Bool:
 		{
-			auto s = get<String>();
-			std::transform( s.begin(), s.end(), s.begin(), tolower );
-			return ( s == "true" || s == "1" || s == "false" || s == "0" );
+			auto s = string_ref();
+			return ( equals_lower( s, "true" ) || s == StringRef( "1" ) || equals_lower( s, "false" ) || s == StringRef( "0" ) );
 		}
 		case Value::Type::Int:
 		{
-			auto s = get<String>();
+			char buffer[small_capacity_ + 1];
+			auto s = c_str( buffer );
 			char* end_ptr = nullptr;
 			errno = 0;
-			auto ret __attribute__((unused)) = strtoll( s.c_str(), &end_ptr, 10 );
-			return ( errno == 0 && end_ptr == ( s.data() + s.length() ) );
+			auto ret __attribute__((unused)) = strtoll( s, &end_ptr, 10 );
+			return ( errno == 0 && end_ptr == ( s + string_ref().size() ) );
 		}
 		case Value::Type::Float:
 		{
-			auto s = get<String>();
+			char buffer[small_capacity_ + 1];
+			auto s = c_str( buffer );
 			char* end_ptr = nullptr;
 			errno = 0;
-			auto ret __attribute__((unused)) = strtod( s.c_str(), &end_ptr );
-			return ( errno == 0 && end_ptr == ( s.data() + s.length() ) );
+			auto ret __attribute__((unused)) = strtod( s, &end_ptr );
+			return ( errno == 0 && end_ptr == ( s + string_ref().size() ) );
 		}
 		case Value::Type::String: return true;
 		case Value::Type::Array:  return false;
@@ -711,7 +1530,7 @@ bool Value::is_convertable( const Value::Type t ) const
 
 int32_t Value::as_int32() const
 {
-	Int i = as( Value::Type::Int ).get_int();
+	Int i = to_int();
 	if ( i > (Int)std::numeric_limits<int32_t>::max() )
 	{
 		return 0;
@@ -721,7 +1540,7 @@ int32_t Value::as_int32() const
 
 uint32_t Value::as_uint32() const
 {
-	Int i = as( Value::Type::Int ).get_int();
+	Int i = to_int();
 	if ( i < 0ll )
 	{
 		return 0u;
@@ -731,7 +1550,7 @@ uint32_t Value::as_uint32() const
 
 uint64_t Value::as_uint64() const
 {
-	Int i = as( Value::Type::Int ).get_int();
+	Int i = to_int();
 	if ( i < 0ll )
 	{
 		return 0ull;
@@ -741,7 +1560,7 @@ uint64_t Value::as_uint64() const
 
 float Value::as_float() const
 {
-	Float f = as( Value::Type::Float ).get_float();
+	Float f = to_float();
 	if ( f < (Float)std::numeric_limits<float>::min() ||
 		 f > (Float)std::numeric_limits<float>::max() )
 	{
@@ -750,6 +1569,140 @@ float Value::as_float() const
 	return (float)f;
 }
 
+bool Value::try_get( Int &out ) const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		out = data().bool_ ? 1 : 0;
+		return true;
+	case Value::Type::Int:
+		out = data().int_;
+		return true;
+	case Value::Type::String:
+		return parse_int( string_ref(), out );
+	default:
+		return false;
+	}
+}
+
+bool Value::try_get( int32_t &out ) const
+{
+	Int i = 0;
+	if ( !try_get( i ) || i < std::numeric_limits<int32_t>::min() || i > std::numeric_limits<int32_t>::max() )
+	{
+		return false;
+	}
+	out = (int32_t)i;
+	return true;
+}
+
+bool Value::try_get( uint32_t &out ) const
+{
+	Int i = 0;
+	if ( !try_get( i ) || i < 0 || i > (Int)std::numeric_limits<uint32_t>::max() )
+	{
+		return false;
+	}
+	out = (uint32_t)i;
+	return true;
+}
+
+bool Value::try_get( uint64_t &out ) const
+{
+	Int i = 0;
+	if ( !try_get( i ) || i < 0 )
+	{
+		return false;
+	}
+	out = (uint64_t)i;
+	return true;
+}
+
+bool Value::try_get( Float &out ) const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		out = data().bool_ ? 1.0 : 0.0;
+		return true;
+	case Value::Type::Int:
+		out = (Float)data().int_;
+		return true;
+	case Value::Type::Float:
+		out = data().float_;
+		return true;
+	case Value::Type::String:
+		return parse_float( string_ref(), out );
+	default:
+		return false;
+	}
+}
+
+bool Value::try_get( float &out ) const
+{
+	Float f = 0.0;
+	if ( !try_get( f ) || std::fabs( f ) > (Float)std::numeric_limits<float>::max() )
+	{
+		return false;
+	}
+	out = (float)f;
+	return true;
+}
+
+bool Value::try_get( Bool &out ) const
+{
+	switch( type_ )
+	{
+	case Value::Type::Bool:
+		out = data().bool_;
+		return true;
+	case Value::Type::Int:
+		out = data().int_ != 0;
+		return true;
+	case Value::Type::Float:
+		out = data().float_ != 0.0;
+		return true;
+	case Value::Type::String:
+	{
+		auto s = string_ref();
+		if ( equals_lower( s, "true" ) || s == StringRef( "1" ) )
+		{
+			out = true;
+			return true;
+		}
+		if ( equals_lower( s, "false" ) || s == StringRef( "0" ) )
+		{
+			out = false;
+			return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+bool Value::try_get( String &out ) const
+{
+	switch( type_ )
+	{
+	case Value::Type::String:
+	{
+		auto s = string_ref();
+		out.assign( s.data(), s.size() );
+		return true;
+	}
+	case Value::Type::Bool:
+	case Value::Type::Int:
+	case Value::Type::Float:
+		out = as( Value::Type::String ).string_ref().str();
+		return true;
+	default:
+		return false;
+	}
+}
+
 bool operator<( const Value::Type lhs, const Value::Type rhs )
 {
 	return (unsigned)lhs < (unsigned)rhs;
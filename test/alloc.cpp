@@ -0,0 +1,165 @@
+
+// Allocation regression tests. Built as a separate binary, since it replaces global operator new.
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <string>
+#include "frozen.hpp"
+#include "json.hpp"
+#include "path.hpp"
+#include "pointer.hpp"
+
+using namespace jsoncpp;
+using namespace jsoncpp::literals;
+
+static std::atomic<size_t> allocations( 0 );
+static std::atomic<size_t> failing_size( SIZE_MAX ); // Allocations of this size or larger fail
+
+void* operator new( size_t size )
+{
+	allocations++;
+	if ( size >= failing_size )
+	{
+		throw std::bad_alloc();
+	}
+	if ( void *p = std::malloc( size ? size : 1 ) )
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete( void *p ) noexcept
+{
+	std::free( p );
+}
+
+static unsigned failures = 0;
+
+template <typename F>
+static void check_no_alloc( F f, const char *expr, int line )
+{
+	auto before = allocations.load();
+	f();
+	auto count = allocations.load() - before;
+	if ( count != 0 )
+	{
+		std::printf( "alloc.cpp:%d: %s made %zu allocation(s)\n", line, expr, count );
+		failures++;
+	}
+}
+
+#define CHECK_NO_ALLOC( expr ) check_no_alloc( [&]() { expr; }, #expr, __LINE__ )
+
+int main()
+{
+	Error e;
+	std::string json = "{\"id\":123,\"ratio\":1.5,\"enabled\":true,\"count\":\"42\",\"big\":\"12345678901234567\","
+		"\"long key name which does not fit\":[1,2,3],\"list\":[{\"a\":1},{\"b\":2}]";
+	for( int i = 0; i < 100; i++ )
+	{
+		json += ",\"member" + std::to_string( i ) + "\":" + std::to_string( i );
+	}
+	json += "}";
+	const Value v = Json::parse( json, e );
+	const Value w = Json::parse( json, e );
+	if ( !e.empty() )
+	{
+		std::printf( "alloc.cpp: parse failed\n" );
+		return 1;
+	}
+	const std::string key = "long key name which does not fit";
+	const std::string missing = "missing key which does not fit either";
+	const std::string big = "12345678901234567";
+	const Value &list = v["list"];
+	Value m = v;
+	m["id"] = 1; // Detaches shared payload
+#ifdef JSONCPP_SORTED_OBJECT
+	v.has( StringRef( missing ) ); // Grows per thread lookup key once
+#endif
+	volatile bool b = false;
+	volatile Value::Int i = 0;
+	volatile Value::Float f = 0;
+	unsigned index = 0;
+	Value::Int n = 0;
+	Value::Float d = 0;
+	Value::Bool flag = false;
+	JsonPointer pointer( "/list/1/b", e );
+	JsonPath query( "$..list[-1:].b", e );
+	JsonPath filter( "$.list[?@.a == 1 || @.b >= 2.5 || @['long key name which does not fit'][0] == 'x']", e );
+	std::vector<const Value*> selected;
+	selected.reserve( 16 );
+
+	CHECK_NO_ALLOC( b = v.has( key ) );
+	CHECK_NO_ALLOC( b = v.has( missing ) );
+	CHECK_NO_ALLOC( b = v.has( "member99" ) );
+	CHECK_NO_ALLOC( b = list.has( 1 ) );
+	CHECK_NO_ALLOC( b = list.find( []( const Value &element ) { return element.has( "b" ); }, index ) );
+	CHECK_NO_ALLOC( b = v.at( key ).is_array() );
+	CHECK_NO_ALLOC( b = v.at( missing.c_str() ).is_none() );
+	CHECK_NO_ALLOC( b = v[key.c_str()].is_array() );
+	CHECK_NO_ALLOC( b = v.has( StringRef( key.data(), 8 ) ) );
+	CHECK_NO_ALLOC( b = v[StringRef( key.data(), key.size() )].is_array() );
+	CHECK_NO_ALLOC( b = m[key.c_str()].is_array() && m[StringRef( key )].is_array() && m.at( key.c_str() ).is_array() );
+	CHECK_NO_ALLOC( b = list.get_array()[0].is_object() );
+	CHECK_NO_ALLOC( i = v.size() + list.size() + v["big"].size() );
+	CHECK_NO_ALLOC( b = v == w );
+	CHECK_NO_ALLOC( b = list == w["list"] );
+	CHECK_NO_ALLOC( b = v["count"] == "42" );
+	CHECK_NO_ALLOC( b = v["big"] == big );
+	CHECK_NO_ALLOC( i = v["id"].as_int() + v["id"].as_int32() + v["id"].as_uint32() + v["id"].as_uint64() );
+	CHECK_NO_ALLOC( i = v["count"].as_int() + v["big"].as_int64() + v["enabled"].as_int() );
+	CHECK_NO_ALLOC( f = v["ratio"].as_double() + v["ratio"].as_float() + v["count"].as_double() + v["id"].as_double() );
+	CHECK_NO_ALLOC( b = v["enabled"].as_bool() || v["count"].as_bool() || v["id"].as_bool() );
+	CHECK_NO_ALLOC( b = v["count"].is_convertable( Value::Type::Int ) && v["big"].is_convertable( Value::Type::Bool ) );
+	CHECK_NO_ALLOC( b = v["big"].string_ref().size() == 17 );
+	CHECK_NO_ALLOC( b = query.first( v ) != nullptr );
+	CHECK_NO_ALLOC( selected.clear(); query.select( v, selected ); b = selected.size() == 1 );
+	CHECK_NO_ALLOC( b = filter.first( v ) != nullptr );
+	pointer.find( m ); // Detaches shared subtree
+	CHECK_NO_ALLOC( b = pointer.find( v ) != nullptr && pointer.find( m ) != nullptr );
+	CHECK_NO_ALLOC( b = v["count"].try_get( n ) && v["big"].try_get( n ) && v["id"].try_get( n ) );
+	CHECK_NO_ALLOC( b = v["count"].try_get( d ) && v["big"].try_get( d ) && v["ratio"].try_get( d ) );
+	CHECK_NO_ALLOC( b = v["enabled"].try_get( flag ) && v["count"].try_as<uint32_t>().first );
+	CHECK_NO_ALLOC( b = v.hash() == w.hash() && v == w );
+	static constexpr auto literal = R"({"a": [1, 2]})"_json;
+	literal.value(); // Parses on first access
+	CHECK_NO_ALLOC( b = literal.value()["a"].size() == 2 );
+	FrozenDocument frozen( v );
+	CHECK_NO_ALLOC( b = frozen.root()["list"][1]["b"].as_double() > 0 && frozen.root().has( "count" ) );
+	CHECK_NO_ALLOC( b = frozen.root()["big"].string_ref().size() == 17 && frozen.root()["missing"]["x"].is_none() );
+
+	// Failed allocation of a parallel build worker reaches the caller
+	Value records( Value::Type::Array );
+	for( int r = 0; r < 1000; r++ )
+	{
+		records.insert( Value( std::string( 1000, 'x' ) ) );
+	}
+	Json::Format parallel;
+	parallel.threads = 4;
+	parallel.parallel_threshold = 10;
+	bool thrown = false;
+	failing_size = 100000;
+	try
+	{
+		Json::build( records, e, parallel );
+	}
+	catch( const std::bad_alloc& )
+	{
+		thrown = true;
+	}
+	failing_size = SIZE_MAX;
+	if ( !thrown )
+	{
+		std::printf( "alloc.cpp:%d: parallel build did not report failed allocation\n", __LINE__ );
+		failures++;
+	}
+
+	(void)b;
+	(void)i;
+	(void)f;
+	std::printf( "%u allocation check(s) failed\n", failures );
+	return failures ? 1 : 0;
+}
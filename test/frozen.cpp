@@ -0,0 +1,127 @@
+#include <string>
+#include <thread>
+#include "json.hpp"
+#include "frozen.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(FrozenGroup)
+{
+	Error e;
+	void setup()
+	{
+		e.clear();
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(FrozenGroup, LookupTest)
+{
+	const Value v = Json::parse( R"({"z":1,"b":[true,2.5,"x",null,{"k":"a string which is not stored inline"}],"a":{"c":-3,"b":{}}, "é":"utf8"})", e );
+	CHECK( e.empty() );
+	FrozenDocument doc( v );
+	FrozenValue root = doc.root();
+
+	CHECK( root.is_object() );
+	UNSIGNED_LONGS_EQUAL( 4, root.size() );
+	STRCMP_EQUAL( "a", root.key( 0 ).data() );
+	STRCMP_EQUAL( "b", root.key( 1 ).data() );
+	STRCMP_EQUAL( "z", root.key( 2 ).data() );
+	STRCMP_EQUAL( "\xc3\xa9", root.key( 3 ).data() );
+	CHECK( root.key( 4 ).empty() );
+
+	LONGS_EQUAL( 1, root["z"].as_int() );
+	CHECK( root["z"].is_int() );
+	LONGS_EQUAL( -3, root["a"]["c"].as_int() );
+	CHECK( root["a"]["b"].is_object() );
+	UNSIGNED_LONGS_EQUAL( 0, root["a"]["b"].size() );
+	CHECK( root[std::string( "\xc3\xa9" )].string_ref() == "utf8" );
+	CHECK( root[1][0].as_bool() );
+	DOUBLES_EQUAL( 2.5, root["b"][1].as_double(), 0 );
+	LONGS_EQUAL( 2, root["b"][1].as_int() );
+	STRCMP_EQUAL( "x", root["b"][2].string_ref().data() );
+	CHECK( root["b"][3].is_none() );
+	STRCMP_EQUAL( "a string which is not stored inline", root["b"][4]["k"].as_string().c_str() );
+	CHECK( root.has( "a" ) );
+	CHECK_FALSE( root.has( "" ) );
+	CHECK_FALSE( root["b"].has( "a" ) );
+
+	// Missing elements are null
+	CHECK( root["missing"].is_none() );
+	CHECK( root["b"][5].is_none() );
+	CHECK( root["z"][0].is_none() );
+	CHECK( root["z"]["a"]["b"].is_none() );
+	CHECK( root["b"][2].key( 0 ).empty() );
+	CHECK( root["b"].string_ref().empty() );
+	CHECK( FrozenValue().is_none() );
+	CHECK( FrozenDocument().root().is_none() );
+
+	CHECK( root.thaw()["b"] == v["b"] );
+	CHECK( root.thaw()["a"] == v["a"] );
+	// Thawed members come in key order
+	STRCMP_EQUAL( R"({"a":{"b":{},"c":-3},"b":)", Json::build( root.thaw(), e ).substr( 0, 25 ).c_str() );
+	CHECK( FrozenDocument( Value( "text" ) ).root().string_ref() == "text" );
+}
+
+TEST(FrozenGroup, LayoutTest)
+{
+	Value v( Value::Type::Array );
+	for( int i = 0; i < 100; i++ )
+	{
+		Value item( Value::Type::Object );
+		item["id"] = i;
+		item["name"] = "item" + std::to_string( i );
+		v.get_array().push_back( item );
+	}
+	FrozenDocument doc( v );
+	FrozenValue root = doc.root();
+
+	// Elements are consecutive records, strings follow all records
+	UNSIGNED_LONGS_EQUAL( 100, root.size() );
+	for( size_t i = 1; i < root.size(); i++ )
+	{
+		LONGS_EQUAL( i, root[i]["id"].as_int() );
+		CHECK( root[i]["name"].string_ref() == StringRef( "item" + std::to_string( i ) ) );
+		CHECK( root[i]["name"].string_ref().data() > root[i - 1]["name"].string_ref().data() );
+	}
+	CHECK( root.thaw() == v );
+
+	// Thawed containers are shared by copies
+	const Value thawed = root.thaw();
+	const Value copy_of_thawed( thawed );
+	CHECK( copy_of_thawed.get_array().data() == thawed.get_array().data() );
+	CHECK( &copy_of_thawed.get_array()[0].get_object() == &thawed.get_array()[0].get_object() );
+
+	// Copies are independent of source
+	v.get_array().clear();
+	CHECK( doc.root()[99]["id"].as_int() == 99 );
+	FrozenDocument copy( doc );
+	CHECK( copy.root()[99]["name"].string_ref() == "item99" );
+	UNSIGNED_LONGS_EQUAL( doc.size(), copy.size() );
+}
+
+TEST(FrozenGroup, ThreadTest)
+{
+	const Value v = Json::parse( R"({"routes":[{"path":"/a","port":1},{"path":"/b","port":2}]})", e );
+	const FrozenDocument doc( v );
+	unsigned failures[2] = { 0, 0 };
+	auto reader = [&doc]( unsigned &failed )
+	{
+		for( int i = 0; i < 1000; i++ )
+		{
+			auto route = doc.root()["routes"][i % 2];
+			if ( route["port"].as_int() != i % 2 + 1 || route["path"].string_ref().size() != 2 )
+			{
+				failed++;
+			}
+		}
+	};
+	std::thread t0( reader, std::ref( failures[0] ) );
+	std::thread t1( reader, std::ref( failures[1] ) );
+	t0.join();
+	t1.join();
+	UNSIGNED_LONGS_EQUAL( 0, failures[0] + failures[1] );
+}
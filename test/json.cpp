@@ -1,4 +1,7 @@
 
+#include <string>
+#include <thread>
+#include <vector>
 #include "json.hpp"
 #include "CppUTest/TestHarness.h"
 
@@ -334,6 +337,75 @@ TEST(JsonGroup, InvalidInputTest)
 	}
 }
 
+TEST(JsonGroup, KeyPoolTest)
+{
+	KeyPool pool;
+	auto a = Json::parse( "[{\"id\":1,\"name\":\"a\"},{\"id\":2,\"name\":\"b\"}]", e, pool );
+	CHECK( e.empty() );
+	auto b = Json::parse( "{\"name\":\"c\"}", e, pool );
+	CHECK( e.empty() );
+	UNSIGNED_LONGS_EQUAL( 2, pool.size() );
+	CHECK( a[1]["id"] == 2 );
+	STRCMP_EQUAL( "c", b["name"].get_string().c_str() );
+
+#ifndef JSONCPP_SORTED_OBJECT
+	// Sorted objects keep keys as std::string, so only ObjectMap shares them
+	const auto &first = a[0].get_object().begin()->first;
+	CHECK( first.shares( a[1].get_object().begin()->first ) );
+	CHECK( ( a[0].get_object().begin() + 1 )->first.shares( b.get_object().begin()->first ) );
+
+	// Without a pool keys are not shared
+	auto c = Json::parse( "[{\"id\":1},{\"id\":2}]", e );
+	CHECK( !c[0].get_object().begin()->first.shares( c[1].get_object().begin()->first ) );
+
+	// Pool keys are escaped once and kept quoted by every build
+	CHECK( first.encoded() == nullptr );
+	STRCMP_EQUAL( "[{\"id\":1,\"name\":\"a\"},{\"id\":2,\"name\":\"b\"}]", Json::build( a, e ).c_str() );
+	const std::string *quoted = first.encoded();
+	CHECK( quoted != nullptr );
+	STRCMP_EQUAL( "\"id\"", quoted->c_str() );
+	STRCMP_EQUAL( "{\n  \"name\": \"c\"\n}", Json::build( b, e, Json::Format( ' ', 2 ) ).c_str() );
+	CHECK( quoted == first.encoded() );
+	CHECK( c[0].get_object().begin()->first.encoded() == nullptr );
+	Json::build( c, e );
+	CHECK( c[0].get_object().begin()->first.encoded() == nullptr );
+	auto d = Json::parse( "{\"a\\\"b\":1}", e, pool );
+	STRCMP_EQUAL( "{\"a\\\"b\":1}", Json::build( d, e ).c_str() );
+	STRCMP_EQUAL( "\"a\\\"b\"", d.get_object().begin()->first.encoded()->c_str() );
+#endif
+}
+
+TEST(JsonGroup, ResourceParseTest)
+{
+	MonotonicResource r;
+	{
+		auto v = Json::parse( "{\"list\":[{\"name\":\"a string longer than cell\"}],\"id\":1}", e, r );
+		CHECK( e.empty() );
+		const Value w( v );
+		const Value &cv = v;
+		CHECK( w.get_object().begin() == cv.get_object().begin() );
+		CHECK( v.resource() == &r );
+		CHECK( v["list"].resource() == &r );
+		CHECK( v["list"][0].resource() == &r );
+		CHECK( v["list"][0]["name"].resource() == &r );
+		CHECK( v["id"] == 1 );
+
+		// Arrays nested in arrays too, empty ones stay arrays
+		auto n = Json::parse( "[[1,2],{\"a\":[[3]]},[]]", e, r );
+		CHECK( e.empty() );
+		const Value &first = n.get_array()[0];
+		const Value &inner = n.get_array()[1]["a"].get_array()[0];
+		const Value &last = n.get_array()[2];
+		CHECK( first.is_array() );
+		CHECK( first.resource() == &r );
+		CHECK( inner.resource() == &r );
+		CHECK( inner.get_array()[0] == 3 );
+		CHECK( last.is_array() );
+		CHECK( last.resource() == &r );
+	}
+	r.release();
+}
+
 TEST(JsonGroup, ToStringTest)
 {
 	Value v( Value::Type::Object );
@@ -353,7 +425,11 @@ TEST(JsonGroup, ToStringTest)
 
 	auto s = Json::build( v, e );
 	CHECK( e.empty() );
-	STRCMP_CONTAINS( "{\"array\":[", s.c_str() );
+#ifndef JSONCPP_SORTED_OBJECT
+	// Members are written in insertion order
+	STRCMP_CONTAINS( "{\"string\":\"test\",", s.c_str() );
+#endif
+	STRCMP_CONTAINS( "\"array\":[", s.c_str() );
 	STRCMP_CONTAINS( "]", s.c_str() );
 	STRCMP_CONTAINS( "\"float\":1.5", s.c_str() );
 	STRCMP_CONTAINS( "\"double\":1.79769e+308", s.c_str() );
@@ -384,7 +460,11 @@ TEST(JsonGroup, ToStringTest)
 
 	s = Json::minimize( s, e );
 	CHECK( e.empty() );
+#ifdef JSONCPP_SORTED_OBJECT
 	STRCMP_EQUAL( "{\"array\":[123,false,\"test\"],\"double\":1.79769e+308,\"float\":1.5,\"number\":123,\"object\":{\"bool\":true,\"key\":\"value\",\"undef\":null},\"string\":\"test\"}", s.c_str() );
+#else
+	STRCMP_EQUAL( "{\"string\":\"test\",\"number\":123,\"object\":{\"key\":\"value\",\"bool\":true,\"undef\":null},\"array\":[123,false,\"test\"],\"float\":1.5,\"double\":1.79769e+308}", s.c_str() );
+#endif
 
 	s = Json::format( "{\"key\":\"value\",\"list\": [123]}", e, Json::Format( ' ', 2 ) );
 	STRCMP_EQUAL( "{\n  \"key\": \"value\",\n  \"list\": [\n    123\n  ]\n}", s.c_str() );
@@ -446,3 +526,281 @@ TEST(JsonGroup, SpecialCharactersTest)
 	CHECK( e.empty() );
 	STRCMP_EQUAL( " \" \\ \b \f \n \r \t ", res["string"].as_string().c_str() );
 }
+
+TEST(JsonGroup, MeasureTest)
+{
+	CHECK_EQUAL( 4u, Json::measure( Value() ) );
+	CHECK_EQUAL( 5u, Json::measure( Value( false ) ) );
+	CHECK_EQUAL( 4u, Json::measure( Value( -123 ) ) );
+	CHECK_EQUAL( 12u, Json::measure( Value( " \" \\ \n " ) ) );
+
+	auto v = Json::parse( "{\"key\":\"value\",\"list\":[123,1.5,null,{\"a\":[]}],\"str\":\"\\t\"}", e );
+	CHECK( e.empty() );
+	auto s = Json::build( v, e );
+	CHECK_EQUAL( s.size(), Json::measure( v ) );
+
+	Json::Format f( ' ', 2 );
+	s = Json::build( v, e, f );
+	CHECK_EQUAL( s.size(), Json::measure( v, f ) );
+}
+
+TEST(JsonGroup, KeyEscapeTest)
+{
+	Value v( Value::Type::Object );
+	v.insert( "a\"b", 1 )
+	 .insert( "c\\d\n", Value( Value::Type::Array ) );
+	for( unsigned i = 0; i < 3; i++ )
+	{
+		Value record( Value::Type::Object );
+		record.insert( "id", i ).insert( "tab\t", true );
+		v["c\\d\n"].insert( std::move( record ) );
+	}
+
+	auto dump = Json::build( v, e );
+	CHECK( e.empty() );
+	STRCMP_EQUAL( "{\"a\\\"b\":1,\"c\\\\d\\n\":[{\"id\":0,\"tab\\t\":true},{\"id\":1,\"tab\\t\":true},{\"id\":2,\"tab\\t\":true}]}", dump.c_str() );
+	CHECK_EQUAL( dump.size(), Json::measure( v ) );
+
+	auto res = Json::parse( dump, e );
+	CHECK( e.empty() );
+	CHECK( res == v );
+
+	Json::Format f( ' ', 1 );
+	dump = Json::build( v, e, f );
+	STRCMP_CONTAINS( " \"a\\\"b\": 1,", dump.c_str() );
+	STRCMP_CONTAINS( "   \"tab\\t\": true", dump.c_str() );
+	CHECK_EQUAL( dump.size(), Json::measure( v, f ) );
+}
+
+TEST(JsonGroup, WriterTest)
+{
+	std::string s;
+	{
+		JsonWriter w( s );
+		w.begin_object()
+		 .key( "string" ).value( "te\"st" )
+		 .key( "number" ).value( 123 )
+		 .key( "array" ).begin_array()
+			.value( 1.5 ).value( false ).value().begin_object().end_object()
+		 .end_array()
+		 .key( "value" ).value( Json::parse( "{\"a\":[1]}", e ) )
+		 .end_object();
+		CHECK( w.complete() );
+		CHECK( w.error().empty() );
+	}
+	STRCMP_EQUAL( "{\"string\":\"te\\\"st\",\"number\":123,\"array\":[1.5,false,null,{}],\"value\":{\"a\":[1]}}", s.c_str() );
+
+	// Pretty printing matches Json::build
+	auto v = Json::parse( s, e );
+	CHECK( e.empty() );
+	Json::Format f( ' ', 2 );
+	std::string pretty;
+	JsonWriter w( pretty, f );
+	w.begin_object()
+	 .key( "string" ).value( "te\"st" )
+	 .key( "number" ).value( 123 )
+	 .key( "array" ).begin_array()
+		.value( 1.5 ).value( false ).value().begin_object().end_object()
+	 .end_array()
+	 .key( "value" ).begin_object().key( "a" ).begin_array().value( 1 ).end_array().end_object()
+	 .end_object();
+	CHECK( w.complete() );
+	CHECK( Json::parse( pretty, e ) == v );
+#ifndef JSONCPP_SORTED_OBJECT
+	// Sorted objects are built in key order rather than written order
+	STRCMP_EQUAL( Json::build( v, e, f ).c_str(), pretty.c_str() );
+#endif
+}
+
+TEST(JsonGroup, WriterSinkTest)
+{
+	std::string s;
+	unsigned chunks = 0;
+	{
+		JsonWriter w( [&]( const char *data, size_t size ) { s.append( data, size ); chunks++; } );
+		w.begin_array();
+		for( unsigned i = 0; i < 10000; i++ )
+		{
+			w.value( i );
+		}
+		w.end_array();
+		CHECK( w.complete() );
+	}
+	CHECK( chunks > 1 );
+	auto v = Json::parse( s, e );
+	CHECK( e.empty() );
+	CHECK_EQUAL( 10000, v.size() );
+	CHECK( v[9999] == 9999 );
+}
+
+TEST(JsonGroup, WriterNestingTest)
+{
+	std::string s;
+	{
+		JsonWriter w( s );
+		w.begin_object().value( 1 );
+		CHECK_FALSE( w.error().empty() );
+		CHECK_EQUAL( Error::UnexpectedToken, w.error().code() );
+		CHECK_FALSE( w.complete() );
+	}
+	{
+		JsonWriter w( s );
+		w.begin_array().key( "a" );
+		CHECK_FALSE( w.error().empty() );
+	}
+	{
+		JsonWriter w( s );
+		w.begin_array().end_object();
+		CHECK_FALSE( w.error().empty() );
+	}
+	{
+		JsonWriter w( s );
+		w.begin_object().key( "a" ).end_object();
+		CHECK_FALSE( w.error().empty() );
+	}
+	{
+		JsonWriter w( s );
+		w.value( 1 ).value( 2 );
+		CHECK_FALSE( w.error().empty() );
+	}
+	{
+		JsonWriter w( s );
+		w.begin_array();
+		CHECK( w.error().empty() );
+		CHECK_FALSE( w.complete() );
+	}
+}
+
+TEST(JsonGroup, ParallelBuildTest)
+{
+	Value v( Value::Type::Object );
+	for( unsigned i = 0; i < 100; i++ )
+	{
+		Value record( Value::Type::Object );
+		record.insert( "id", i )
+			  .insert( "name", "record \"" + std::to_string( i ) + "\"" )
+			  .insert( "list", Value( Value::Type::Array ) );
+		record["list"].insert( i ).insert( true );
+		v["records"].insert( std::move( record ) );
+		v.insert( "key" + std::to_string( i ), i );
+	}
+
+	Json::Format f;
+	auto serial = Json::build( v, e, f );
+	f.threads = 4;
+	f.parallel_threshold = 10;
+	auto parallel = Json::build( v, e, f );
+	CHECK( e.empty() );
+	STRCMP_EQUAL( serial.c_str(), parallel.c_str() );
+	// Root was split, so string is sized from chunks exactly
+	UNSIGNED_LONGS_EQUAL( parallel.size(), parallel.capacity() );
+
+	f = Json::Format( '\t', 1 );
+	serial = Json::build( v, e, f );
+	f.threads = 0;
+	f.parallel_threshold = 2;
+	parallel = Json::build( v, e, f );
+	STRCMP_EQUAL( serial.c_str(), parallel.c_str() );
+}
+
+TEST(JsonGroup, SegmentsTest)
+{
+	std::string blob( 1000, 'x' );
+	std::string escaped = std::string( 300, 'a' ) + "\n" + std::string( 10, 'b' );
+	Value v( Value::Type::Object );
+	v.insert( "blob", blob )
+	 .insert( "escaped", escaped )
+	 .insert( "list", Value( Value::Type::Array ) );
+	v["list"].insert( 1 ).insert( "short" );
+
+	Json::Segments segments;
+	Json::build( v, e, Json::Format(), segments );
+	CHECK( e.empty() );
+	std::string joined;
+	for( auto &i : segments.iov )
+	{
+		joined.append( (const char*)i.iov_base, i.iov_len );
+	}
+	STRCMP_EQUAL( Json::build( v, e ).c_str(), joined.c_str() );
+	CHECK_EQUAL( joined.size(), segments.size() );
+
+	// Long strings are referenced in place
+	const auto &stored_blob = v["blob"].get_string();
+	const auto &stored_escaped = v["escaped"].get_string();
+	unsigned references = 0;
+	for( auto &i : segments.iov )
+	{
+		if ( i.iov_base == stored_blob.data() && i.iov_len == blob.size() )
+		{
+			references++;
+		}
+		if ( i.iov_base == stored_escaped.data() && i.iov_len == 300 )
+		{
+			references++;
+		}
+	}
+	CHECK_EQUAL( 2, references );
+
+	Json::Format f( ' ', 2 );
+	Json::build( v, e, f, segments );
+	joined.clear();
+	for( auto &i : segments.iov )
+	{
+		joined.append( (const char*)i.iov_base, i.iov_len );
+	}
+	STRCMP_EQUAL( Json::build( v, e, f ).c_str(), joined.c_str() );
+}
+
+TEST(JsonGroup, LiteralTest)
+{
+	using namespace jsoncpp::literals;
+	static constexpr auto config = R"({"name": "test", "limits": [1, 2]})"_json;
+	static_assert( config.size() == 34, "Literal is constant" );
+
+	const Value &v = config.value( e );
+	CHECK( e.empty() );
+	STRCMP_EQUAL( "test", v["name"].as_string().c_str() );
+	CHECK( v["limits"].get_array()[1] == 2 );
+
+	// Parsed once
+	CHECK( &v == &config.value() );
+	const Value &same = config;
+	CHECK( &v == &same );
+
+	auto bad = "{\"a\":"_json;
+	CHECK( bad.value( e ).is_none() );
+	CHECK_EQUAL( Error::UnexpectedEnding, e.code() );
+
+	// Many literals, parsed concurrently by several threads, resolve to one value each.
+	// Texts live until exit, like literal text does
+	static std::vector<std::string> texts;
+	for( int i = 0; i < 200; i++ )
+	{
+		texts.push_back( "[" + std::to_string( i ) + "]" );
+	}
+	const Value *seen[2][200];
+	unsigned failures[2] = { 0, 0 };
+	std::vector<std::thread> threads;
+	for( int t = 0; t < 2; t++ )
+	{
+		threads.emplace_back( [&, t]()
+		{
+			for( int i = 0; i < 200; i++ )
+			{
+				const Value &v = operator"" _json( texts[i].data(), texts[i].size() );
+				seen[t][i] = &v;
+				failures[t] += v.get_array()[0] == i ? 0 : 1;
+				failures[t] += &config.value() == &same ? 0 : 1;
+			}
+		} );
+	}
+	for( auto &t : threads )
+	{
+		t.join();
+	}
+	for( int i = 0; i < 200; i++ )
+	{
+		failures[0] += seen[0][i] == seen[1][i] ? 0 : 1;
+	}
+	UNSIGNED_LONGS_EQUAL( 0, failures[0] + failures[1] );
+}
@@ -0,0 +1,70 @@
+#include <string>
+#include "key.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(KeyGroup)
+{
+	void setup()
+	{
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(KeyGroup, CompareTest)
+{
+	Key empty;
+	CHECK( empty.empty() );
+	STRCMP_EQUAL( "", empty.c_str() );
+	CHECK( empty == Key( "" ) );
+
+	Key a( "name" );
+	Key b( std::string( "name" ) );
+	Key c( a );
+	CHECK( a == b );
+	CHECK( !a.shares( b ) );
+	CHECK( a.shares( c ) );
+	CHECK( a == "name" );
+	CHECK( "name" == a );
+	CHECK( a == std::string( "name" ) );
+	CHECK( a != "other" );
+	UNSIGNED_LONGS_EQUAL( Key::hash( "name", 4 ), a.hash() );
+
+	const std::string &s = a;
+	CHECK( s.c_str() == c.c_str() );
+	c = Key( "other" );
+	STRCMP_EQUAL( "name", a.c_str() );
+	CHECK( a < c );
+}
+
+TEST(KeyGroup, PoolTest)
+{
+	KeyPool pool;
+	Key a = pool.intern( "name" );
+	Key b = pool.intern( std::string( "name" ) );
+	Key c = pool.intern( "value" );
+	CHECK( a.shares( b ) );
+	CHECK( !a.shares( c ) );
+	UNSIGNED_LONGS_EQUAL( 2, pool.size() );
+
+	// Keys outlive the pool
+	pool.clear();
+	UNSIGNED_LONGS_EQUAL( 0, pool.size() );
+	STRCMP_EQUAL( "name", b.c_str() );
+	CHECK( !a.shares( pool.intern( "name" ) ) );
+
+	// Only interned keys keep encoded form, first stored one wins
+	CHECK( a.interned() );
+	CHECK( !Key( "name" ).interned() );
+	CHECK( a.encoded() == nullptr );
+	const std::string &stored = a.encode( "\"name\"" );
+	CHECK( &stored == b.encoded() );
+	CHECK( &a.encode( "other" ) == &stored );
+	STRCMP_EQUAL( "\"name\"", b.encoded()->c_str() );
+	Key plain( "name" );
+	STRCMP_EQUAL( "\"name\"", plain.encode( "\"name\"" ).c_str() );
+	CHECK( plain.encoded() == nullptr );
+}
@@ -0,0 +1,53 @@
+#include <cstdint>
+#include <vector>
+#include "memory_resource.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(MemoryResourceGroup)
+{
+	void setup()
+	{
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(MemoryResourceGroup, MonotonicTest)
+{
+	MonotonicResource r( 64 );
+	auto a = r.allocate( 3, 1 );
+	auto b = r.allocate( 8, 8 );
+	CHECK( a != b );
+	UNSIGNED_LONGS_EQUAL( 0, (uintptr_t)b % 8 );
+
+	// Oversized allocations get their own block
+	auto c = static_cast<char*>( r.allocate( 1000, 16 ) );
+	UNSIGNED_LONGS_EQUAL( 0, (uintptr_t)c % 16 );
+	c[999] = 1;
+	r.deallocate( c, 1000, 16 );
+	r.release();
+
+	std::vector<int, Allocator<int> > v( ( Allocator<int>( &r ) ) );
+	for( int i = 0; i < 100; i++ )
+	{
+		v.push_back( i );
+	}
+	CHECK( v.get_allocator().resource() == &r );
+	auto copy( v );
+	CHECK( copy.get_allocator() == v.get_allocator() );
+	CHECK( Allocator<int>() != v.get_allocator() );
+	CHECK( Allocator<char>() == Allocator<int>() );
+}
+
+TEST(MemoryResourceGroup, DefaultTest)
+{
+	MonotonicResource r;
+	auto previous = set_default_resource( &r );
+	CHECK( default_resource() == &r );
+	CHECK( Allocator<int>().resource() == &r );
+	set_default_resource( previous );
+	CHECK( default_resource() == previous );
+}
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include <string>
+#include "object.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(ObjectGroup)
+{
+	void setup()
+	{
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(ObjectGroup, OrderTest)
+{
+	ObjectMap<int> m = { { "b", 1 }, { "a", 2 }, { "c", 3 }, { "a", 4 } };
+	UNSIGNED_LONGS_EQUAL( 3, m.size() );
+	std::string keys;
+	for( const auto &i : m )
+	{
+		keys += i.first;
+	}
+	STRCMP_EQUAL( "bac", keys.c_str() );
+	CHECK_EQUAL( 2, m.at( "a" ) );
+
+	m["d"] = 5;
+	CHECK( !m.emplace( "d", 6 ).second );
+	CHECK_EQUAL( 5, m["d"] );
+	UNSIGNED_LONGS_EQUAL( 1, m.erase( "a" ) );
+	UNSIGNED_LONGS_EQUAL( 0, m.erase( "a" ) );
+	CHECK( m.find( "a" ) == m.end() );
+	STRCMP_EQUAL( "c", ( m.begin() + 1 )->first.c_str() );
+	CHECK_THROWS( std::out_of_range, m.at( "a" ) );
+
+	ObjectMap<int> r = { { "d", 5 }, { "c", 3 }, { "b", 1 } };
+	CHECK( m == r );
+	r["c"] = 0;
+	CHECK( m != r );
+}
+
+TEST(ObjectGroup, IndexTest)
+{
+	ObjectMap<unsigned> m;
+	const unsigned count = 1000;
+	for( unsigned i = 0; i < count; i++ )
+	{
+		CHECK( m.emplace( std::to_string( i ), i ).second );
+	}
+	UNSIGNED_LONGS_EQUAL( count, m.size() );
+	for( unsigned i = 0; i < count; i++ )
+	{
+		auto it = m.find( std::to_string( i ) );
+		CHECK( it != m.end() );
+		UNSIGNED_LONGS_EQUAL( i, it->second );
+		UNSIGNED_LONGS_EQUAL( i, ( m.begin() + i )->second );
+	}
+	CHECK( m.find( "missing" ) == m.end() );
+	CHECK( m.find( StringRef( "9990", 3 ) )->second == 999 );
+	UNSIGNED_LONGS_EQUAL( 0, m.count( StringRef( "9990" ) ) );
+
+	// Erasing keeps order and index consistent
+	for( unsigned i = 0; i < count; i += 2 )
+	{
+		UNSIGNED_LONGS_EQUAL( 1, m.erase( std::to_string( i ) ) );
+	}
+	UNSIGNED_LONGS_EQUAL( count / 2, m.size() );
+	for( unsigned i = 0; i < count; i++ )
+	{
+		UNSIGNED_LONGS_EQUAL( i % 2, m.count( std::to_string( i ) ) );
+	}
+	UNSIGNED_LONGS_EQUAL( 1, m.begin()->second );
+
+	// Erasing by iterator from the middle, until index is dropped, and appending again
+	for( unsigned left = count / 2; left > 4; left-- )
+	{
+		auto it = m.erase( m.begin() + left / 2 );
+		CHECK( it == m.begin() + left / 2 );
+		for( auto &member : m )
+		{
+			CHECK( m.find( member.first ) != m.end() && m.find( member.first )->second == member.second );
+		}
+	}
+	UNSIGNED_LONGS_EQUAL( 4, m.size() );
+	for( unsigned i = 0; i < count; i += 2 )
+	{
+		m[std::to_string( i )] = i;
+	}
+	for( unsigned i = 0; i < count; i += 2 )
+	{
+		UNSIGNED_LONGS_EQUAL( i, m.at( std::to_string( i ) ) );
+	}
+	UNSIGNED_LONGS_EQUAL( 1, m.begin()->second );
+
+	// Copies carry a usable index
+	ObjectMap<unsigned> c( m );
+	UNSIGNED_LONGS_EQUAL( 998, c.at( "998" ) );
+	c.clear();
+	CHECK( c.empty() );
+	CHECK( c.find( "999" ) == c.end() );
+}
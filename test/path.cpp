@@ -0,0 +1,163 @@
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "path.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(PathGroup)
+{
+	Error e;
+	Value store;
+
+	void setup()
+	{
+		e.clear();
+		// Example document from RFC 9535
+		store = Json::parse( R"({"store":{
+			"book":[
+				{"category":"reference","author":"Nigel Rees","title":"Sayings of the Century","price":8.95},
+				{"category":"fiction","author":"Evelyn Waugh","title":"Sword of Honour","price":12.99},
+				{"category":"fiction","author":"Herman Melville","title":"Moby Dick","isbn":"0-553-21311-3","price":8.99},
+				{"category":"fiction","author":"J. R. R. Tolkien","title":"The Lord of the Rings","isbn":"0-395-19395-8","price":22.99}
+			],
+			"bicycle":{"color":"red","price":399}}})", e );
+	}
+	void teardown()
+	{
+	}
+
+	std::vector<const Value*> select( const std::string &path )
+	{
+		std::vector<const Value*> result;
+		JsonPath p( path, e );
+		CHECK( e.empty() );
+		p.select( static_cast<const Value&>( store ), result );
+		return result;
+	}
+
+	std::string titles( const std::string &path )
+	{
+		std::string s;
+		for( auto v : select( path ) )
+		{
+			s += ( s.empty() ? "" : "," ) + (*v)["title"].as_string();
+		}
+		return s;
+	}
+};
+
+TEST(PathGroup, SelectorTest)
+{
+	auto authors = select( "$.store.book[*].author" );
+	UNSIGNED_LONGS_EQUAL( 4, authors.size() );
+	CHECK( *authors[0] == "Nigel Rees" );
+	CHECK( *authors[3] == "J. R. R. Tolkien" );
+
+	UNSIGNED_LONGS_EQUAL( 4, select( "$..author" ).size() );
+	UNSIGNED_LONGS_EQUAL( 2, select( "$.store.*" ).size() );
+	UNSIGNED_LONGS_EQUAL( 5, select( "$.store..price" ).size() );
+	UNSIGNED_LONGS_EQUAL( 27, select( "$..*" ).size() );
+	UNSIGNED_LONGS_EQUAL( 1, select( "$" ).size() );
+	CHECK( select( "$['store']['bicycle']" )[0] == &store["store"]["bicycle"] );
+	CHECK( *select( "$[\"store\"].bicycle.color" )[0] == "red" );
+	CHECK( select( "$.missing" ).empty() );
+	CHECK( select( "$.store.book.title" ).empty() );
+
+	STRCMP_EQUAL( "Moby Dick", titles( "$..book[2]" ).c_str() );
+	STRCMP_EQUAL( "The Lord of the Rings", titles( "$..book[-1]" ).c_str() );
+	STRCMP_EQUAL( "Sayings of the Century,Sword of Honour", titles( "$..book[0,1]" ).c_str() );
+	STRCMP_EQUAL( "Sayings of the Century,Sword of Honour", titles( "$..book[:2]" ).c_str() );
+	STRCMP_EQUAL( "Sword of Honour,The Lord of the Rings", titles( "$.store.book[1::2]" ).c_str() );
+	STRCMP_EQUAL( "The Lord of the Rings,Moby Dick,Sword of Honour,Sayings of the Century", titles( "$.store.book[::-1]" ).c_str() );
+	STRCMP_EQUAL( "Moby Dick,The Lord of the Rings", titles( "$.store.book[-2:10]" ).c_str() );
+	STRCMP_EQUAL( "", titles( "$.store.book[0:4:0]" ).c_str() );
+	STRCMP_EQUAL( "", titles( "$.store.book[7]" ).c_str() );
+}
+
+TEST(PathGroup, FilterTest)
+{
+	STRCMP_EQUAL( "Moby Dick,The Lord of the Rings", titles( "$..book[?@.isbn]" ).c_str() );
+	STRCMP_EQUAL( "Sayings of the Century,Moby Dick", titles( "$..book[?(@.price < 10)]" ).c_str() );
+	STRCMP_EQUAL( "Sword of Honour,Moby Dick,The Lord of the Rings", titles( "$..book[?@.price>$.store.book[0].price]" ).c_str() );
+	STRCMP_EQUAL( "Sword of Honour", titles( "$..book[?@.price > 10 && @.price <= 22.99 && !@.isbn]" ).c_str() );
+	STRCMP_EQUAL( "Sayings of the Century,The Lord of the Rings", titles( "$..book[?@.category == 'reference' || @.price >= 20]" ).c_str() );
+	STRCMP_EQUAL( "Sword of Honour,Moby Dick,The Lord of the Rings", titles( "$..book[?@.category != \"reference\"]" ).c_str() );
+	STRCMP_EQUAL( "Moby Dick", titles( "$..book[?(@.author > 'H' && @.author < 'I')]" ).c_str() );
+	STRCMP_EQUAL( "", titles( "$..book[?@.missing == null]" ).c_str() );
+	STRCMP_EQUAL( "Sayings of the Century,Sword of Honour,Moby Dick,The Lord of the Rings", titles( "$..book[?@.missing == @.other]" ).c_str() );
+
+	// Numbers compare across int and float
+	Value v = Json::parse( R"({"a":[{"n":1},{"n":1.0},{"n":"1"},{"n":true}]})", e );
+	JsonPath p( "$.a[?@.n == 1]", e );
+	std::vector<const Value*> result;
+	p.select( static_cast<const Value&>( v ), result );
+	UNSIGNED_LONGS_EQUAL( 2, result.size() );
+}
+
+TEST(PathGroup, MutableTest)
+{
+	JsonPath p( "$.store.book[?@.price < 10].price", e );
+	CHECK( e.empty() );
+	std::vector<Value*> prices;
+	p.select( store, prices );
+	UNSIGNED_LONGS_EQUAL( 2, prices.size() );
+	for( auto price : prices )
+	{
+		*price = 10;
+	}
+	CHECK( store["store"]["book"][0]["price"] == 10 );
+	CHECK( store["store"]["book"][2]["price"] == 10 );
+	CHECK( p.first( store ) == nullptr );
+
+	const Value &c = store;
+	CHECK( JsonPath( "$..bicycle.color", e ).first( c ) == &c["store"]["bicycle"]["color"] );
+}
+
+TEST(PathGroup, DetachTest)
+{
+	// Only values on the way to selected ones are detached from copies
+	const Value &c = store;
+	const Value copy( store );
+	Value *color = JsonPath( "$..bicycle.color", e ).first( store );
+	CHECK( color != nullptr );
+	*color = "green";
+	CHECK( c["store"]["book"].get_array().data() == copy["store"]["book"].get_array().data() );
+	CHECK( &c["store"]["bicycle"].get_object() != &copy["store"]["bicycle"].get_object() );
+	CHECK( copy["store"]["bicycle"]["color"] == "red" );
+	CHECK( c["store"]["bicycle"]["color"] == "green" );
+	std::vector<Value*> prices;
+	JsonPath( "$..book[?@.price > 20].price", e ).select( store, prices );
+	UNSIGNED_LONGS_EQUAL( 1, prices.size() );
+	CHECK( &c["store"]["book"].get_array()[1].get_object() == &copy["store"]["book"].get_array()[1].get_object() );
+}
+
+TEST(PathGroup, ParseErrorTest)
+{
+	const char *bad[] = { "", "store", "$.", "$[", "$['a'", "$[?@.a ==]", "$[?'a']", "$[1:x]", "$['\\x']", "$.a b", "$[?(@.a]",
+		"$[?(@.x) == 1]", "$[?@.a == 1 == 2]",
+		"$[?@.* == 1]", "$[?@..a == 1]", "$[?1 < @[0:1]]", "$[?@['a','b'] == 1]", "$[?$.a[?@.b] == 1]", "$[01]", "$[-0]", "$[1:02]", "$[0:10:9223372036854775807]", "$[9007199254740992]" };
+	for( auto path : bad )
+	{
+		Error error;
+		JsonPath p( path, error );
+		CHECK( !error.empty() );
+		CHECK( p.first( store ) == nullptr );
+	}
+	Error error;
+	JsonPath p;
+	CHECK( p.first( store ) == nullptr );
+	CHECK( p.init( "$['a\\u00e9\\'']", error ) );
+	CHECK( error.empty() );
+	CHECK( p.init( "$[?@.a[0].b == $['c'][-1] && @.* && $..d]", error ) );
+	CHECK( error.empty() );
+
+	// Largest I-JSON integers are accepted
+	CHECK( p.init( "$[0:10:9007199254740991]", error ) );
+	CHECK( p.init( "$[-9007199254740991:0]", error ) );
+	CHECK( error.empty() );
+	STRCMP_EQUAL( "Sayings of the Century", titles( "$.store.book[0:4:9007199254740991]" ).c_str() );
+	STRCMP_EQUAL( "The Lord of the Rings", titles( "$.store.book[3:-5:-9007199254740991]" ).c_str() );
+	STRCMP_EQUAL( "", titles( "$.store.book[-9007199254740991]" ).c_str() );
+}
@@ -0,0 +1,117 @@
+#include <string>
+#include "json.hpp"
+#include "pointer.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+TEST_GROUP(PointerGroup)
+{
+	Error e;
+	void setup()
+	{
+		e.clear();
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(PointerGroup, ParseTest)
+{
+	JsonPointer p;
+	CHECK( p.init( "", e ) );
+	UNSIGNED_LONGS_EQUAL( 0, p.size() );
+	CHECK( p.init( "/", e ) );
+	UNSIGNED_LONGS_EQUAL( 1, p.size() );
+	CHECK( p.init( "/a/b~1c/~0/0/-", e ) );
+	UNSIGNED_LONGS_EQUAL( 5, p.size() );
+	STRCMP_EQUAL( "/a/b~1c/~0/0/-", p.str().c_str() );
+	CHECK( e.empty() );
+
+	CHECK_FALSE( p.init( "a", e ) );
+	UNSIGNED_LONGS_EQUAL( Error::UnexpectedCharacter, e.code() );
+	e.clear();
+	CHECK_FALSE( p.init( "/a~2", e ) );
+	UNSIGNED_LONGS_EQUAL( Error::UnexpectedCharacter, e.code() );
+	e.clear();
+	CHECK_FALSE( JsonPointer( "/a~", e ).size() );
+	CHECK_FALSE( e.empty() );
+}
+
+TEST(PointerGroup, FindTest)
+{
+	// Examples from RFC 6901, except for empty key, which parser rejects
+	const Value doc = Json::parse( R"({"foo":["bar","baz"],"a/b":1,"c%d":2,"e^f":3,"g|h":4,"i\\j":5,"k\"l":6," ":7,"m~n":8})", e );
+	CHECK( e.empty() );
+	CHECK( JsonPointer( "", e ).find( doc ) == &doc );
+	CHECK( *JsonPointer( "/foo", e ).find( doc ) == doc["foo"] );
+	CHECK( *JsonPointer( "/foo/0", e ).find( doc ) == "bar" );
+	CHECK( *JsonPointer( "/a~1b", e ).find( doc ) == 1 );
+	CHECK( *JsonPointer( "/c%d", e ).find( doc ) == 2 );
+	CHECK( *JsonPointer( "/e^f", e ).find( doc ) == 3 );
+	CHECK( *JsonPointer( "/g|h", e ).find( doc ) == 4 );
+	CHECK( *JsonPointer( "/i\\j", e ).find( doc ) == 5 );
+	CHECK( *JsonPointer( "/k\"l", e ).find( doc ) == 6 );
+	CHECK( *JsonPointer( "/ ", e ).find( doc ) == 7 );
+	CHECK( *JsonPointer( "/m~0n", e ).find( doc ) == 8 );
+	CHECK( e.empty() );
+
+	CHECK( JsonPointer( "/foo/2", e ).find( doc ) == nullptr );
+	CHECK( JsonPointer( "/foo/-", e ).find( doc ) == nullptr );
+	CHECK( JsonPointer( "/foo/01", e ).find( doc ) == nullptr );
+	CHECK( JsonPointer( "/foo/bar", e ).find( doc ) == nullptr );
+	CHECK( JsonPointer( "/missing/0", e ).find( doc ) == nullptr );
+	CHECK( JsonPointer( "/a~1b/0", e ).find( doc ) == nullptr );
+
+	// Numeric tokens are keys for objects
+	const Value o = Json::parse( R"({"0":{"1":true}})", e );
+	CHECK( *JsonPointer( "/0/1", e ).find( o ) == true );
+
+	Value empty_key( Value::Type::Object );
+	empty_key.insert( "", 0 );
+	CHECK( *JsonPointer( "/", e ).find( empty_key ) == 0 );
+}
+
+TEST(PointerGroup, MutableTest)
+{
+	Value doc = Json::parse( R"({"a":{"b":[1,2]}})", e );
+	const Value copy( doc );
+	JsonPointer p( "/a/b/1", e );
+	*p.find( doc ) = 3;
+	CHECK( doc["a"]["b"][1] == 3 );
+	CHECK( copy.get_object().begin()->second.get_object().begin()->second.get_array()[1] == 2 );
+
+	CHECK( JsonPointer( "/a/c/d", e ).find( doc ) == nullptr );
+	*JsonPointer( "/a/c/d", e ).create( doc ) = "x";
+	CHECK( doc["a"]["c"]["d"] == "x" );
+	*JsonPointer( "/a/b/-", e ).create( doc ) = 4;
+	*JsonPointer( "/a/b/3", e ).create( doc ) = 5;
+	UNSIGNED_LONGS_EQUAL( 4, doc["a"]["b"].size() );
+	CHECK( doc["a"]["b"][3] == 5 );
+	*JsonPointer( "/n/-/k", e ).create( doc ) = true;
+	CHECK( doc["n"][0]["k"] == true );
+	CHECK( e.empty() );
+
+	CHECK( JsonPointer( "/a/b/9", e ).create( doc ) == nullptr );
+	CHECK( JsonPointer( "/a/b/x", e ).create( doc ) == nullptr );
+	CHECK( JsonPointer( "/a/c/d/e", e ).create( doc ) == nullptr );
+
+	// Failed create() doesn't touch the document, not even to unshare its payloads
+	const Value before( doc );
+	doc = before;
+	const Value &cdoc = doc;
+	CHECK( &cdoc.get_object() == &before.get_object() );
+	CHECK( JsonPointer( "/a/c/d/e", e ).create( doc ) == nullptr );
+	CHECK( JsonPointer( "/a/b/x/y", e ).create( doc ) == nullptr );
+	CHECK( JsonPointer( "/a/b/0/z", e ).create( doc ) == nullptr );
+	CHECK( &cdoc.get_object() == &before.get_object() );
+	CHECK( &cdoc.get_object().find( "a" )->second.get_object() == &before.get_object().find( "a" )->second.get_object() );
+	CHECK( JsonPointer( "/a/x/y", e ).create( doc ) != nullptr );
+	CHECK( &cdoc.get_object() != &before.get_object() );
+	CHECK( !before["a"].has( "x" ) );
+
+	Value empty;
+	*JsonPointer( "/x/y", e ).create( empty ) = 1;
+	CHECK( empty["x"]["y"] == 1 );
+}
@@ -0,0 +1,189 @@
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+#include "reflect.hpp"
+#include "CppUTest/TestHarness.h"
+
+using namespace jsoncpp;
+
+namespace test
+{
+
+struct Point
+{
+	int x;
+	double y;
+};
+
+struct Shape
+{
+	std::string name;
+	std::vector<Point> points;
+	std::map<std::string, unsigned> tags;
+	std::array<bool, 2> flags;
+	Point center;
+	Value extra;
+};
+
+JSONCPP_REFLECT( Point, x, y )
+JSONCPP_REFLECT( Shape, name, points, tags, flags, center, extra )
+
+} // namespace test
+
+TEST_GROUP(ReflectGroup)
+{
+	Error e;
+	void setup()
+	{
+		e.clear();
+	}
+	void teardown()
+	{
+	}
+};
+
+TEST(ReflectGroup, TraitsTest)
+{
+	CHECK( IsReflected<test::Point>::value );
+	CHECK( IsReflected<test::Shape>::value );
+	CHECK_FALSE( IsReflected<int>::value );
+	CHECK_FALSE( IsReflected<std::string>::value );
+}
+
+TEST(ReflectGroup, BuildTest)
+{
+	STRCMP_EQUAL( "123", Reflect::build( 123, e ).c_str() );
+	STRCMP_EQUAL( "true", Reflect::build( true, e ).c_str() );
+	STRCMP_EQUAL( "1.5", Reflect::build( 1.5f, e ).c_str() );
+	STRCMP_EQUAL( "\"a\\\"b\"", Reflect::build( std::string( "a\"b" ), e ).c_str() );
+	STRCMP_EQUAL( "[1,2,3]", Reflect::build( std::vector<int>{ 1, 2, 3 }, e ).c_str() );
+	STRCMP_EQUAL( "{\"x\":-1,\"y\":0.5}", Reflect::build( test::Point{ -1, 0.5 }, e ).c_str() );
+
+	test::Shape shape;
+	shape.name = "line";
+	shape.points = { { 0, 0 }, { 1, 1.5 } };
+	shape.tags = { { "a", 1 }, { "b", 2 } };
+	shape.flags = { { true, false } };
+	shape.center = { 5, 6 };
+	shape.extra = Json::parse( "{\"k\":[null]}", e );
+	auto s = Reflect::build( shape, e );
+	CHECK( e.empty() );
+	STRCMP_EQUAL( "{\"name\":\"line\",\"points\":[{\"x\":0,\"y\":0},{\"x\":1,\"y\":1.5}],\"tags\":{\"a\":1,\"b\":2},"
+				  "\"flags\":[true,false],\"center\":{\"x\":5,\"y\":6},\"extra\":{\"k\":[null]}}", s.c_str() );
+
+	// Same document as built through Value
+	auto v = Json::parse( s, e );
+	CHECK( e.empty() );
+	Json::Format f( ' ', 2 );
+	STRCMP_EQUAL( Json::build( v, e, f ).c_str(), Json::format( Reflect::build( shape, e, f ), e, f ).c_str() );
+}
+
+TEST(ReflectGroup, HashTest)
+{
+	CHECK_EQUAL( reflect_hash( "field" ), reflect_hash( std::string( "field" ) ) );
+	CHECK( reflect_hash( "x" ) != reflect_hash( "y" ) );
+	static_assert( reflect_hash( "" ) == 2166136261u, "FNV-1a offset basis" );
+}
+
+TEST(ReflectGroup, ParseTest)
+{
+	test::Shape shape;
+	CHECK( Reflect::parse( "{\"name\":\"line\",\"unknown\":{\"a\":[1,{\"b\":null}]},\"points\":[{\"x\":0,\"y\":0},{\"y\":1.5,\"x\":1}],"
+						   "\"tags\":{\"a\":1,\"b\":2},\"flags\":[true,false],\"center\":{\"x\":5,\"z\":7,\"y\":6},\"extra\":{\"k\":[null]}}", shape, e ) );
+	CHECK( e.empty() );
+	STRCMP_EQUAL( "line", shape.name.c_str() );
+	CHECK_EQUAL( 2, shape.points.size() );
+	CHECK_EQUAL( 1, shape.points[1].x );
+	DOUBLES_EQUAL( 1.5, shape.points[1].y, 0.0 );
+	CHECK_EQUAL( 2, shape.tags.size() );
+	CHECK_EQUAL( 2u, shape.tags["b"] );
+	CHECK( shape.flags[0] );
+	CHECK_FALSE( shape.flags[1] );
+	CHECK_EQUAL( 5, shape.center.x );
+	DOUBLES_EQUAL( 6.0, shape.center.y, 0.0 );
+	CHECK( shape.extra["k"][0].is_none() );
+	CHECK_EQUAL( 1, shape.extra["k"].size() );
+
+	// Round trip
+	test::Shape copy;
+	CHECK( Reflect::parse( Reflect::build( shape, e ), copy, e ) );
+	STRCMP_EQUAL( Reflect::build( shape, e ).c_str(), Reflect::build( copy, e ).c_str() );
+
+	std::vector<int> list;
+	CHECK( Reflect::parse( " [ 1 , 2 , 3 ] ", list, e ) );
+	CHECK_EQUAL( 3, list.size() );
+	CHECK_EQUAL( 3, list[2] );
+
+	// Unsigned numbers read back over their whole range
+	std::vector<uint64_t> big = { UINT64_MAX, (uint64_t)INT64_MAX + 1, 0 };
+	std::vector<uint64_t> big_copy;
+	CHECK( Reflect::parse( Reflect::build( big, e ), big_copy, e ) );
+	CHECK( big == big_copy );
+	uint64_t u = 1;
+	CHECK( Reflect::parse( "-0", u, e ) );
+	CHECK_EQUAL( 0u, u );
+}
+
+TEST(ReflectGroup, ParseNestedTest)
+{
+	// Nesting is limited by memory rather than by call stack
+	std::string deep = std::string( 1000000, '[' ) + std::string( 1000000, ']' );
+	test::Point p;
+	CHECK( Reflect::parse( "{\"x\":1,\"skipped\":" + deep + ",\"y\":2}", p, e ) );
+	CHECK( e.empty() );
+	CHECK_EQUAL( 1, p.x );
+	DOUBLES_EQUAL( 2.0, p.y, 0.0 );
+
+	std::string nested = std::string( 1000, '[' ) + "{\"a\":[1,{}]}" + std::string( 1000, ']' );
+	Value v;
+	CHECK( Reflect::parse( nested, v, e ) );
+	CHECK( e.empty() );
+	CHECK( v == Json::parse( nested, e ) );
+	STRCMP_EQUAL( nested.c_str(), Json::build( v, e ).c_str() );
+
+	CHECK_FALSE( Reflect::parse( std::string( 1000000, '[' ), v, e ) );
+	CHECK_EQUAL( Error::UnexpectedEnding, e.code() );
+}
+
+TEST(ReflectGroup, ParseErrorTest)
+{
+	test::Point p;
+	CHECK_FALSE( Reflect::parse( "{\"x\":\"1\"}", p, e ) );
+	CHECK_EQUAL( Error::UnexpectedType, e.code() );
+	e.clear();
+
+	CHECK_FALSE( Reflect::parse( "{\"x\":1,}", p, e ) );
+	CHECK_EQUAL( Error::UnexpectedToken, e.code() );
+	e.clear();
+
+	CHECK_FALSE( Reflect::parse( "{\"x\":1", p, e ) );
+	CHECK_EQUAL( Error::UnexpectedEnding, e.code() );
+	e.clear();
+
+	CHECK_FALSE( Reflect::parse( "{\"x\":1} {}", p, e ) );
+	CHECK_EQUAL( Error::UnexpectedEnding, e.code() );
+	e.clear();
+
+	uint8_t u = 0;
+	CHECK_FALSE( Reflect::parse( "256", u, e ) );
+	CHECK_EQUAL( Error::OutOfRange, e.code() );
+	e.clear();
+	CHECK_FALSE( Reflect::parse( "-1", u, e ) );
+	CHECK_EQUAL( Error::OutOfRange, e.code() );
+	e.clear();
+	uint64_t u64 = 0;
+	CHECK_FALSE( Reflect::parse( "-1", u64, e ) );
+	CHECK_EQUAL( Error::OutOfRange, e.code() );
+	e.clear();
+	CHECK_FALSE( Reflect::parse( "18446744073709551616", u64, e ) );
+	CHECK_EQUAL( Error::OutOfRange, e.code() );
+	e.clear();
+	int8_t i = 0;
+	CHECK( Reflect::parse( "-128", i, e ) );
+	CHECK_EQUAL( -128, i );
+
+	std::array<int, 2> a;
+	CHECK_FALSE( Reflect::parse( "[1,2,3]", a, e ) );
+	CHECK_EQUAL( Error::OutOfRange, e.code() );
+}
@@ -4,6 +4,10 @@
 #include <map>
 #include <memory>
 #include <limits>
+#include <algorithm>
+#include <clocale>
+#include <thread>
+#include <unordered_set>
 #include "value.hpp"
 #include "CppUTest/TestHarness.h"
 
@@ -32,6 +36,58 @@ TEST(ValueGroup, SwapTest)
 	Value c( std::move( a ) );
 	UNSIGNED_LONGS_EQUAL( Value::Type::String, c.type() );
 	STRCMP_EQUAL( "test", c.get_string().c_str() );
+
+	// Storage is exchanged, not copied
+	Value d( Value::Type::Object );
+	d["key"] = std::string( 100, 'x' );
+	const char *chars = d["key"].get_string().data();
+	c.swap( d );
+	UNSIGNED_LONGS_EQUAL( Value::Type::Object, c.type() );
+	UNSIGNED_LONGS_EQUAL( Value::Type::String, d.type() );
+	CHECK( chars == c["key"].get_string().data() );
+
+	using std::swap;
+	swap( c, d );
+	CHECK( chars == d["key"].get_string().data() );
+	STRCMP_EQUAL( "test", c.get_string().c_str() );
+
+	std::vector<Value> values = { Value( 3 ), Value( 1 ), Value( 2 ) };
+	std::sort( values.begin(), values.end(), []( const Value &l, const Value &r ) { return l.get_int() < r.get_int(); } );
+	CHECK( values[0] == 1 );
+	CHECK( values[2] == 3 );
+}
+
+TEST(ValueGroup, MoveTest)
+{
+	CHECK( std::is_nothrow_move_constructible<Value>::value );
+	CHECK( std::is_nothrow_move_assignable<Value>::value );
+
+	Value a( Value::Type::Array );
+	for( unsigned i = 0; i < 100; i++ )
+	{
+		a.insert( Value( std::string( 100, 'x' ) ) );
+	}
+	const Value *elements = a.get_array().data();
+	const char *chars = a[0].get_string().data();
+
+	// Contents are moved, not copied
+	Value b( std::move( a ) );
+	CHECK( a.is_none() );
+	CHECK( elements == b.get_array().data() );
+	CHECK( chars == b[0].get_string().data() );
+
+	a = std::move( b );
+	CHECK( b.is_none() );
+	CHECK( elements == a.get_array().data() );
+
+	Value o;
+	o.insert( "key", std::move( a ) );
+	CHECK( elements == o["key"].get_array().data() );
+
+	std::string s( 100, 'y' );
+	const char *s_chars = s.data();
+	Value v( std::move( s ) );
+	CHECK( s_chars == v.get_string().data() );
 }
 
 TEST(ValueGroup, NoneTest)
@@ -302,7 +358,7 @@ TEST(ValueGroup, ArrayTest)
 	o.insert( "type", 2 );
 	a.insert( std::move( o ) );
 	auto pred = []( const std::string &user, const Value &o ) -> bool {
-		return o.has( "user" ) && o["user"].get_string() == user;
+		return o.has( "user" ) && o["user"].string_ref() == user;
 	};
 	unsigned i;
 	CHECK( a.find( std::bind( pred, "usr1", std::placeholders::_1 ), i ) );
@@ -361,6 +417,404 @@ TEST(ValueGroup, ObjectTest)
 	v.erase( "key2" );
 	CHECK_EQUAL( 1, v.size() );
 	CHECK( 123 == v.at( "key1" ) );
+
+	// Keys may be slices of other strings
+	const char *path = "key1.key2";
+	CHECK( v.has( StringRef( path, 4 ) ) );
+	CHECK_FALSE( v.has( StringRef( path, 3 ) ) );
+	CHECK( 123 == v[StringRef( path, 4 )] );
+	const Value &c = o;
+	CHECK( "test" == c.at( StringRef( path + 5, 4 ) ) );
+	CHECK( c[StringRef( path, 3 )].empty() );
+	v[StringRef( path + 5, 4 )] = 1;
+	CHECK( v.has( "key2" ) );
+	CHECK_EQUAL( 2, v.size() );
+}
+
+TEST(ValueGroup, CompactTest)
+{
+	CHECK( sizeof( Value ) <= 16 );
+
+	// Copies are deep
+	Value a( Value::Type::Object );
+	a["list"].insert( Value( "item" ) );
+	Value b( a );
+	b["list"][0] = 5;
+	STRCMP_EQUAL( "item", a["list"][0].get_string().c_str() );
+	CHECK( b["list"][0] == 5 );
+
+	// Assigning a child to its parent
+	a = a["list"];
+	UNSIGNED_LONGS_EQUAL( Value::Type::Array, a.type() );
+	STRCMP_EQUAL( "item", a[0].get_string().c_str() );
+	a = std::move( a[0] );
+	STRCMP_EQUAL( "item", a.get_string().c_str() );
+	a = a.get_string();
+	STRCMP_EQUAL( "item", a.get_string().c_str() );
+}
+
+TEST(ValueGroup, SmallStringTest)
+{
+	auto inside = []( const Value &v ) {
+		auto p = (const char*)v.string_ref().data();
+		return p >= (const char*)&v && p < (const char*)( &v + 1 );
+	};
+
+	Value a( "short string" );
+	CHECK( inside( a ) );
+	UNSIGNED_LONGS_EQUAL( 12, a.size() );
+	CHECK( a == "short string" );
+	CHECK( a == std::string( "short string" ) );
+
+	Value b( std::string( "a string longer than cell" ) );
+	CHECK( !inside( b ) );
+	CHECK( b == "a string longer than cell" );
+
+	// Copies and moves keep short strings inline
+	Value c( a );
+	CHECK( inside( c ) );
+	CHECK( a == c );
+	Value d( std::move( c ) );
+	CHECK( inside( d ) );
+	CHECK( c.is_none() );
+
+	// Const access copies, string stays in the cell
+	const Value &ca = a;
+	STRCMP_EQUAL( "short string", ca.as_string().c_str() );
+	CHECK( inside( a ) );
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+	// Deprecated reference access copies short strings into per-thread slots,
+	// heap strings are returned as they are
+	const Value cb( b );
+	const Value cd( "other" );
+	const std::string &s = ca.get_string();
+	STRCMP_EQUAL( "short string", s.c_str() );
+	CHECK( &cb.get_string() == &cb.get_string() );
+	CHECK( ca.get_string() != cd.get_string() );
+	CHECK( ca.get<Value::String>() == ca.get_string() );
+	STRCMP_EQUAL( "a string longer than cell", cb.get_string().c_str() );
+	CHECK( Value( 1 ).get_string().empty() );
+	CHECK( inside( a ) );
+#pragma GCC diagnostic pop
+
+	// Mutable access moves the string out of the cell
+	a.get_string() += "!";
+	CHECK( !inside( a ) );
+	CHECK( a == "short string!" );
+	Value e( a );
+	CHECK( inside( e ) );
+	CHECK( a == e );
+	CHECK( a != d );
+
+	StringRef r( "abc" );
+	CHECK( r == std::string( "abc" ) );
+	CHECK( r != StringRef( "ab" ) );
+	STRCMP_EQUAL( "abc", r.str().c_str() );
+}
+
+namespace
+{
+
+struct CountingResource : MemoryResource
+{
+	unsigned allocations = 0;
+	unsigned deallocations = 0;
+
+	void* do_allocate( size_t bytes, size_t ) override
+	{
+		allocations++;
+		return ::operator new( bytes );
+	}
+	void do_deallocate( void *p, size_t, size_t ) override
+	{
+		deallocations++;
+		::operator delete( p );
+	}
+};
+
+} // namespace
+
+TEST(ValueGroup, ResourceTest)
+{
+	CountingResource r;
+	{
+		Value a( Value::Type::Array, &r );
+		CHECK( a.resource() == &r );
+		a.insert( Value( "a string longer than cell" ) );
+		a.insert( Value( Value::Type::Object ) );
+		a[1]["key"] = 1;
+		CHECK( a[0].resource() == &r );
+		CHECK( a[1].resource() == &r );
+		CHECK( a.get_array().get_allocator().resource() == &r );
+
+		// Copies stay in the same resource
+		Value b( a );
+		CHECK( b.resource() == &r );
+		CHECK( b[1].resource() == &r );
+		CHECK( a == b );
+
+		// Or are moved to another one
+		Value c( a, default_resource() );
+		CHECK( c.resource() == default_resource() );
+		CHECK( c[0].resource() == default_resource() );
+		CHECK( a == c );
+
+		Value s( std::string( "another string longer than cell" ), &r );
+		CHECK( s.resource() == &r );
+		CHECK( r.allocations > 0 );
+	}
+	UNSIGNED_LONGS_EQUAL( r.allocations, r.deallocations );
+}
+
+TEST(ValueGroup, CowTest)
+{
+	CountingResource r;
+	{
+		Value a( Value::Type::Array, &r );
+		a.insert( Value( "a string longer than cell" ) );
+		a.insert( Value( Value::Type::Object ) );
+		a.insert( 1 );
+		auto allocations = r.allocations;
+
+		// Copies share payload until modified
+		const Value b( a );
+		const Value &ca = a;
+		CHECK( b.get_array().data() == ca.get_array().data() );
+		UNSIGNED_LONGS_EQUAL( allocations, r.allocations );
+
+		Value c( b );
+		c.insert( 2 );
+		CHECK( c.get_array().data() != b.get_array().data() );
+		UNSIGNED_LONGS_EQUAL( 3, b.get_array().size() );
+		UNSIGNED_LONGS_EQUAL( 4, c.get_array().size() );
+		CHECK( b == a );
+		c.erase( 3 );
+		CHECK( c == b );
+
+		// Mutable references pin payload to its owner, later copies are deep
+		Value d( a );
+		a.get<Value::Array>()[2] = 3;
+		CHECK( d[2] == 1 );
+		CHECK( a[2] == 3 );
+		const Value e( a );
+		CHECK( e.get_array().data() != ca.get_array().data() );
+		a[2] = 4;
+		CHECK( e.get_array()[2] == 3 );
+
+		// Strings and objects too
+		Value s( b.get_array()[0] );
+		const Value t( s );
+		const Value &cs = s;
+		CHECK( t.string_ref().data() == cs.string_ref().data() );
+		s.get<Value::String>() += "!";
+		STRCMP_EQUAL( "a string longer than cell", t.as_string().c_str() );
+
+		Value o( Value::Type::Object, &r );
+		o.insert( "key", 1 );
+		Value p( o );
+		p.insert( "other", 2 );
+		CHECK( !o.has( "other" ) );
+		CHECK( p.has( "key" ) );
+		p.erase( "key" );
+		CHECK( o.has( "key" ) );
+
+		// Copy of a value with handed out references is shareable again
+		const Value g( a );
+		const Value h( g );
+		CHECK( h.get_array().data() == g.get_array().data() );
+
+		// Sharing is limited to one resource
+		const Value f( b, default_resource() );
+		CHECK( f.get_array().data() != b.get_array().data() );
+		CHECK( f == b );
+	}
+	UNSIGNED_LONGS_EQUAL( r.allocations, r.deallocations );
+}
+
+TEST(ValueGroup, TryGetTest)
+{
+	Value::Int i = 7;
+	CHECK( Value( "-9223372036854775808" ).try_get( i ) );
+	CHECK( i == std::numeric_limits<Value::Int>::min() );
+	CHECK( Value( "+42" ).try_get( i ) );
+	CHECK_EQUAL( 42, i );
+	CHECK( Value( true ).try_get( i ) );
+	CHECK_EQUAL( 1, i );
+	CHECK_FALSE( Value( "9223372036854775808" ).try_get( i ) );
+	CHECK_FALSE( Value( " 1" ).try_get( i ) );
+	CHECK_FALSE( Value( "1.5" ).try_get( i ) );
+	CHECK_FALSE( Value( "" ).try_get( i ) );
+	CHECK_FALSE( Value( 1.5 ).try_get( i ) );
+	CHECK_FALSE( Value().try_get( i ) );
+	CHECK_EQUAL( 1, i );
+
+	auto i32 = Value( "2147483648" ).try_as<int32_t>();
+	CHECK_FALSE( i32.first );
+	i32 = Value( "-2147483648" ).try_as<int32_t>();
+	CHECK( i32.first );
+	CHECK_EQUAL( std::numeric_limits<int32_t>::min(), i32.second );
+	CHECK_FALSE( Value( -1 ).try_as<uint32_t>().first );
+	CHECK_FALSE( Value( -1 ).try_as<uint64_t>().first );
+	CHECK_EQUAL( 4294967295u, Value( "4294967295" ).try_as<uint32_t>().second );
+
+	Value::Float f = 0.0;
+	CHECK( Value( "0.1" ).try_get( f ) );
+	CHECK( f == 0.1 );
+	CHECK( Value( "-1.25e-3" ).try_get( f ) );
+	CHECK( f == -1.25e-3 );
+	CHECK( Value( "12345678901234567890123" ).try_get( f ) );
+	CHECK( f == 12345678901234567890123.0 );
+	CHECK( Value( "2.2250738585072014e-308" ).try_get( f ) );
+	CHECK( f == 2.2250738585072014e-308 );
+	CHECK( Value( "0.000000000000000000000000000001" ).try_get( f ) );
+	CHECK( f == 1e-30 );
+	CHECK( Value( "1." ).try_get( f ) );
+	CHECK( f == 1.0 );
+	CHECK( Value( 3 ).try_get( f ) );
+	CHECK( f == 3.0 );
+	CHECK_FALSE( Value( "1e400" ).try_get( f ) );
+	CHECK_FALSE( Value( "1,5" ).try_get( f ) );
+	CHECK_FALSE( Value( "1e" ).try_get( f ) );
+	CHECK_FALSE( Value( "." ).try_get( f ) );
+	CHECK_FALSE( Value( "inf" ).try_get( f ) );
+	CHECK_FALSE( Value( "1e40" ).try_as<float>().first );
+
+	Value::Bool b = false;
+	CHECK( Value( "TRUE" ).try_get( b ) );
+	CHECK( b );
+	CHECK( Value( "0" ).try_get( b ) );
+	CHECK_FALSE( b );
+	CHECK_FALSE( Value( "yes" ).try_get( b ) );
+
+	Value::String s;
+	CHECK( Value( 12 ).try_get( s ) );
+	STRCMP_EQUAL( "12", s.c_str() );
+	CHECK_FALSE( Value( Value::Type::Array ).try_get( s ) );
+
+	// Parsing ignores locale decimal separator
+	if ( setlocale( LC_NUMERIC, "de_DE.UTF-8" ) )
+	{
+		CHECK( Value( "0.5" ).try_get( f ) );
+		CHECK( f == 0.5 );
+		CHECK( Value( "1.7976931348623157e308" ).try_get( f ) );
+		CHECK( f == 1.7976931348623157e308 );
+		setlocale( LC_NUMERIC, "C" );
+	}
+}
+
+TEST(ValueGroup, MissingElementTest)
+{
+	Value a( Value::Type::Array );
+	a.insert( 1 );
+	// Missing element is writable, but never keeps data between lookups
+	a[5] = 2;
+	CHECK( a[5].is_none() );
+	a.get<Value::String>() = "x";
+	CHECK( a.get<Value::String>().empty() );
+	const Value &c = a;
+	CHECK( c["key"].is_none() );
+	CHECK( c.string_ref().empty() );
+
+	// And is not shared between threads
+	Value *missing[2] = { nullptr, nullptr };
+	Value::Int *ints[2] = { nullptr, nullptr };
+	unsigned failures[2] = { 0, 0 };
+	Value d( Value::Type::Object );
+	d.insert( "name", "short" );
+	const Value doc( std::move( d ) );
+	std::vector<std::thread> threads;
+	for( int i = 0; i < 2; i++ )
+	{
+		threads.emplace_back( [&, i]()
+		{
+			Value v( Value::Type::Array );
+			for( int j = 0; j < 1000; j++ )
+			{
+				missing[i] = &v.at( 10 );
+				*missing[i] = j;
+				ints[i] = &v.get<Value::Int>();
+				*ints[i] = j;
+				failures[i] += doc["key"].is_none() ? 0 : 1;
+				failures[i] += doc["name"].string_ref() == "short" ? 0 : 1;
+			}
+		} );
+	}
+	for( auto &t : threads )
+	{
+		t.join();
+	}
+	CHECK( missing[0] != missing[1] );
+	CHECK( ints[0] != ints[1] );
+	UNSIGNED_LONGS_EQUAL( 0, failures[0] + failures[1] );
+}
+
+TEST(ValueGroup, HashTest)
+{
+	// Equal values hash equally, object members in any order
+	Value o1( Value::Type::Object );
+	o1.insert( "a", 1 );
+	o1.insert( "b", "a string longer than cell" );
+	Value o2( Value::Type::Object );
+	o2.insert( "b", "a string longer than cell" );
+	o2.insert( "a", 1 );
+	CHECK( o1 == o2 );
+	CHECK( o1.hash() == o2.hash() );
+	Value s( "short" );
+	Value l( "short" );
+	l.get<Value::String>() += ""; // Moves string to heap
+	CHECK( s.hash() == l.hash() );
+	CHECK( Value( 0.5 ).hash() == Value( 0.5 + 1e-17 ).hash() );
+	CHECK( Value( 1e100 ).hash() == Value( 1e100 ).hash() );
+	CHECK( Value().hash() == Value().hash() );
+
+	// Array element order and types matter
+	Value a( Value::Type::Array );
+	a.insert( 1 );
+	a.insert( 2 );
+	Value b( Value::Type::Array );
+	b.insert( 2 );
+	b.insert( 1 );
+	CHECK( a.hash() != b.hash() );
+	CHECK( Value( 1 ).hash() != Value( 1.0 ).hash() );
+	CHECK( Value( 1 ).hash() != Value( true ).hash() );
+	CHECK( Value( "1" ).hash() != Value( 1 ).hash() );
+	CHECK( Value( true ).hash() != Value( false ).hash() );
+	CHECK( Value( 2.5 ).hash() != Value( 3.5 ).hash() );
+
+	// Cached hash follows modifications
+	const Value copy( a );
+	uint64_t h = a.hash();
+	CHECK( copy.hash() == h );
+	a.insert( 3 );
+	CHECK( a.hash() != h );
+	CHECK( copy.hash() == h );
+	a.erase( 2 );
+	CHECK( a.hash() == h );
+	auto &elements = a.get_array();
+	CHECK( a.hash() == h );
+	elements[0] = 5;
+	CHECK( a.hash() != h );
+	h = o1.hash();
+	o1["c"]["d"] = 1;
+	CHECK( o1.hash() != h );
+	o1.erase( "c" );
+	CHECK( o1.hash() == h );
+
+	// Values with cached hashes compare quickly, with the same result
+	CHECK( copy == Value( copy ) );
+	CHECK( copy != b );
+	CHECK( o1 == o2 );
+	o2["b"] = "other";
+	CHECK( o1 != o2 );
+
+	std::unordered_set<Value> set;
+	set.insert( o1 );
+	set.insert( o2 );
+	set.insert( Value( o1 ) );
+	set.insert( copy );
+	UNSIGNED_LONGS_EQUAL( 3, set.size() );
+	CHECK( set.count( o1 ) == 1 );
 }
 
 TEST(ValueGroup, DefaultValue)
@@ -790,4 +1244,13 @@ TEST(ValueGroup, AsType)
 	// Object -> Object
 	CHECK( obj_value.as( Value::Type::Object ).is( Value::Type::Object ) );
 	CHECK( obj_value.as_object().empty() );
+	///////////
+	// Strings are converted in place, inline or not
+	CHECK_EQUAL( true, Value( "TRUE" ).as_bool() );
+	CHECK_EQUAL( false, Value( "yes" ).as_bool() );
+	CHECK( Value( "False" ).is_convertable( Value::Type::Bool ) );
+	CHECK_EQUAL( INT64_C( 12345678901234567 ), Value( "12345678901234567" ).as_int() );
+	CHECK_EQUAL( 0, Value( "12345678901234567x" ).as_int() );
+	DOUBLES_EQUAL( 0.125, Value( "0.125000000000000000" ).as_double(), std::numeric_limits<Value::Float>::epsilon() );
+	CHECK_EQUAL( 0, Value( std::string( "1\0" "2", 3 ) ).as_int() );
 }
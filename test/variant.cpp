@@ -1,5 +1,7 @@
 #include <cassert>
 #include <memory>
+#include <string>
+#include <vector>
 #include "variant.hpp"
 
 #include <CppUTest/CommandLineTestRunner.h>
@@ -102,7 +104,7 @@ TEST(VariantGroup, StructTest)
 		unsigned &ctr;
 		S( unsigned &ctr ) : ctr( ctr ) { this->ctr++; }
 		S( const S &s ) : ctr( s.ctr ) { this->ctr++; }
-		S( const S &&s ) : ctr( s.ctr ) {}
+		S( S &&s ) : ctr( s.ctr ) { this->ctr++; }
 		~S() { ctr--; }
 	};
 	unsigned c = 0;
@@ -128,6 +130,32 @@ TEST(VariantGroup, MoveTest)
 	v3 = 5;
 	auto v4 = Variant<int, bool>( std::move( v3 ) );
 	CHECK_EQUAL( 5, *v4.get<int>() );
+
+	// Contents are moved, not copied
+	Variant<std::vector<int>, bool> v5( std::vector<int>( 100, 1 ) );
+	const int *data = v5.get<std::vector<int> >()->data();
+	Variant<std::vector<int>, bool> v6( std::move( v5 ) );
+	CHECK( v5.empty() );
+	CHECK( data == v6.get<std::vector<int> >()->data() );
+	v5 = std::move( v6 );
+	CHECK( v6.empty() );
+	CHECK( data == v5.get<std::vector<int> >()->data() );
+	CHECK( std::is_nothrow_move_constructible<decltype( v5 )>::value );
+	CHECK( std::is_nothrow_move_assignable<decltype( v5 )>::value );
+}
+
+TEST(VariantGroup, SelfAssignTest)
+{
+	// Argument aliasing current contents is consumed before they are destroyed
+	Variant<int, std::string, std::vector<std::string> > v( std::string( 100, 'x' ) );
+	v.set( *v.get<std::string>() );
+	CHECK( *v.get<std::string>() == std::string( 100, 'x' ) );
+	v.set( std::move( *v.get<std::string>() ) );
+	CHECK( *v.get<std::string>() == std::string( 100, 'x' ) );
+
+	v.set( std::vector<std::string>( 3, std::string( 50, 'y' ) ) );
+	v.set( v.get<std::vector<std::string> >()->back() );
+	CHECK( *v.get<std::string>() == std::string( 50, 'y' ) );
 }
 
 TEST(VariantGroup, ConstVisitorTest)
@@ -157,3 +185,28 @@ TEST(VariantGroup, ConstVisitorTest)
 	v.accept( visitor );
 	CHECK_EQUAL( 4, visitor.i );
 }
+
+TEST(VariantGroup, VisitTest)
+{
+	struct Visitor
+	{
+		int operator()() { return -1; }
+		int operator()( const int &i ) { return i; }
+		int operator()( const bool &b ) { return b ? 1 : 0; }
+		int operator()( const std::string &s ) { return (int)s.size(); }
+	} visitor;
+	Variant<int, bool, std::string> v;
+	CHECK_EQUAL( -1, v.visit( visitor ) );
+
+	v = 42;
+	CHECK_EQUAL( 42, v.visit( visitor ) );
+
+	v = true;
+	CHECK_EQUAL( 1, v.visit( visitor ) );
+
+	v = std::string( "test" );
+	CHECK_EQUAL( 4, v.visit( visitor ) );
+
+	// No per-instance dispatch state
+	CHECK( sizeof( Variant<int64_t, double> ) <= 16 );
+}